@@ -0,0 +1,122 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <string.h>
+
+#include "codec.hxx"
+#include "jobs.hxx"
+#include "mem.hxx"
+#include "tests.hxx"
+
+UINT32 TestFailures;
+BOOL TestBenchmark;
+
+BOOL ReportTestFailure(LPCSTR szFile, INT nLine, LPCSTR szExpression) {
+    printf("FAILED %s(%d): %s\n", szFile, nLine, szExpression);
+    TestFailures++;
+
+    return FALSE;
+}
+
+BOOL IsBenchmarkRequested() {
+    return TestBenchmark;
+}
+
+double GetTestTime() {
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+
+// Test files go to the temporary folder of the user.
+VOID GetTestWavePath(LPSTR lpszPath, LPCSTR lpszName) {
+    CHAR folder[MAX_PATH];
+    if (GetTempPathA(MAX_PATH, folder) == 0) { folder[0] = '\0'; }
+
+    snprintf(lpszPath, MAX_PATH, "%swasp-%s.wav", folder, lpszName);
+}
+
+// Writes a RIFF WAVE file, with a fact chunk when the number of frames is not 0.
+// Samples are repeated until the sample data is of the size.
+BOOL WriteLongTestWave(LPCSTR lpszPath, CONST LPWAVEFORMATEX lpFormat,
+    LPCVOID lpSamples, DWORD dwSamplesSize, DWORD dwSize, DWORD dwFactFrames) {
+    FILE* file = fopen(lpszPath, "wb");
+    if (file == NULL) { return FALSE; }
+
+    CONST DWORD format = lpFormat->wFormatTag == WAVE_FORMAT_PCM
+        ? sizeof(PCMWAVEFORMAT) : sizeof(WAVEFORMATEX) + lpFormat->cbSize;
+    CONST DWORD fact = dwFactFrames != 0 ? 12 : 0;
+    CONST DWORD riff = 4 + 8 + format + fact + 8 + dwSize;
+
+    fwrite("RIFF", 1, 4, file);
+    fwrite(&riff, sizeof(DWORD), 1, file);
+    fwrite("WAVEfmt ", 1, 8, file);
+    fwrite(&format, sizeof(DWORD), 1, file);
+    fwrite(lpFormat, 1, format, file);
+
+    if (dwFactFrames != 0) {
+        CONST DWORD size = sizeof(DWORD);
+        fwrite("fact", 1, 4, file);
+        fwrite(&size, sizeof(DWORD), 1, file);
+        fwrite(&dwFactFrames, sizeof(DWORD), 1, file);
+    }
+
+    fwrite("data", 1, 4, file);
+    fwrite(&dwSize, sizeof(DWORD), 1, file);
+
+    for (DWORD written = 0; written < dwSize; written += min(dwSamplesSize, dwSize - written)) {
+        fwrite(lpSamples, 1, min(dwSamplesSize, dwSize - written), file);
+    }
+
+    return fclose(file) == 0;
+}
+
+BOOL WriteTestWave(LPCSTR lpszPath, CONST LPWAVEFORMATEX lpFormat,
+    LPCVOID lpSamples, DWORD dwSize, DWORD dwFactFrames) {
+    return WriteLongTestWave(lpszPath, lpFormat, lpSamples, dwSize, dwSize, dwFactFrames);
+}
+
+// Runs all tests, benchmarks are run too when the first argument is "bench".
+int main(int argc, char* argv[]) {
+    TestBenchmark = 1 < argc && strcmp(argv[1], "bench") == 0;
+
+    InitializeMemory();
+    InitializeCodecs();
+    InitializeJobs(TEST_JOB_WORKERS, 0);
+
+    RunCacheTests();
+    RunCodecTests();
+    RunDitherTests();
+    RunJobTests();
+    RunScrubTests();
+    RunStoreTests();
+    RunTimelineTests();
+    RunWaveTests();
+
+    ReleaseJobs();
+
+    printf(TestFailures == 0 ? "All tests passed.\n" : "%u test(s) failed.\n", TestFailures);
+
+    return TestFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,234 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "cache.hxx"
+#include "tests.hxx"
+
+#define CACHE_TEST_WAVES        4
+#define CACHE_TEST_RATE         44100
+#define CACHE_TEST_CHANNELS     2
+#define CACHE_TEST_FRAMES       (CACHE_TEST_RATE / 20)
+#define CACHE_TEST_SIZE         (CACHE_TEST_FRAMES * CACHE_TEST_CHANNELS * sizeof(SHORT))    // In Bytes
+
+// Room for the samples of a wave three times the usual size. Even that is loaded in full
+// by OpenWave, so no file stays open for a loading job once the wave is opened.
+SHORT CacheTestSamples[3 * CACHE_TEST_FRAMES * CACHE_TEST_CHANNELS];
+CHAR CacheTestPaths[CACHE_TEST_WAVES][MAX_PATH];
+
+BOOL WriteCacheTestWave(UINT32 nIndex, DWORD dwSize) {
+    WAVEFORMATEX format;
+    ZeroMemory(&format, sizeof(WAVEFORMATEX));
+    format.wFormatTag = WAVE_FORMAT_PCM;
+    format.nChannels = CACHE_TEST_CHANNELS;
+    format.nSamplesPerSec = CACHE_TEST_RATE;
+    format.wBitsPerSample = 16;
+    format.nBlockAlign = CACHE_TEST_CHANNELS * sizeof(SHORT);
+    format.nAvgBytesPerSec = CACHE_TEST_RATE * format.nBlockAlign;
+
+    return WriteTestWave(CacheTestPaths[nIndex], &format, CacheTestSamples, dwSize, 0);
+}
+
+BOOL IsCacheTestWaveCached(WAVECACHEPTR lpCache, UINT32 nIndex) {
+    for (UINT32 i = 0; i < lpCache->nCount; i++) {
+        if (strcmp(lpCache->lpEntries[i].lpWave->szPath, CacheTestPaths[nIndex]) == 0) { return TRUE; }
+    }
+
+    return FALSE;
+}
+
+// Opens the wave through the cache and leaves it there, if it was cached at all.
+VOID UseCacheTestWave(WAVECACHEPTR lpCache, UINT32 nIndex) {
+    WAVEPTR wav = OpenCachedWave(lpCache, CacheTestPaths[nIndex], JOBPRIORITY_LOAD);
+
+    CHECK(wav != NULL);
+    ReleaseWave(wav);
+}
+
+// The least recently used wave goes first when the cache is full, reopening a wave counts as a use.
+VOID TestWaveCacheOrder() {
+    WAVECACHEPTR cache = InitializeWaveCache(CACHE_TEST_WAVES * CACHE_TEST_SIZE, 3, 0, FALSE);
+    if (!CHECK(cache != NULL)) { return; }
+
+    UseCacheTestWave(cache, 0);
+    UseCacheTestWave(cache, 1);
+    UseCacheTestWave(cache, 2);
+    UseCacheTestWave(cache, 0);
+    UseCacheTestWave(cache, 3);
+
+    CHECK(cache->nCount == 3);
+    CHECK(IsCacheTestWaveCached(cache, 0) && !IsCacheTestWaveCached(cache, 1));
+    CHECK(IsCacheTestWaveCached(cache, 2) && IsCacheTestWaveCached(cache, 3));
+
+    // A hit hands out the cached wave itself.
+    WAVEPTR first = OpenCachedWave(cache, CacheTestPaths[2], JOBPRIORITY_LOAD);
+    WAVEPTR second = OpenCachedWave(cache, CacheTestPaths[2], JOBPRIORITY_LOAD);
+
+    CHECK(first != NULL && first == second);
+    CHECK(cache->nCount == 3);
+
+    ReleaseWave(first);
+    ReleaseWave(second);
+    ReleaseWaveCache(cache);
+}
+
+// Waves are evicted until the new one fits the budget, a wave larger than the budget is not cached.
+VOID TestWaveCacheBudget() {
+    WAVECACHEPTR cache = InitializeWaveCache(CACHE_TEST_SIZE * 5 / 2, CACHE_TEST_WAVES, 0, FALSE);
+    if (!CHECK(cache != NULL)) { return; }
+
+    UseCacheTestWave(cache, 0);
+    UseCacheTestWave(cache, 1);
+
+    CHECK(cache->nCount == 2);
+
+    UseCacheTestWave(cache, 2);
+
+    CHECK(cache->nCount == 2 && !IsCacheTestWaveCached(cache, 0));
+    CHECK(IsCacheTestWaveCached(cache, 1) && IsCacheTestWaveCached(cache, 2));
+
+    // Twice the size takes both of the cached waves away.
+    if (CHECK(WriteCacheTestWave(3, 2 * CACHE_TEST_SIZE))) {
+        UseCacheTestWave(cache, 3);
+
+        CHECK(cache->nCount == 1 && IsCacheTestWaveCached(cache, 3));
+    }
+
+    // The oversized wave is still handed out, without being cached.
+    if (CHECK(WriteCacheTestWave(3, 3 * CACHE_TEST_SIZE))) {
+        UseCacheTestWave(cache, 1);
+
+        WAVEPTR wav = OpenCachedWave(cache, CacheTestPaths[3], JOBPRIORITY_LOAD);
+
+        CHECK(wav != NULL && GetWaveMemorySize(wav) == 3 * CACHE_TEST_SIZE);
+        CHECK(cache->nCount == 1 && IsCacheTestWaveCached(cache, 1));
+
+        ReleaseWave(wav);
+    }
+
+    CHECK(WriteCacheTestWave(3, CACHE_TEST_SIZE));
+
+    ReleaseWaveCache(cache);
+}
+
+// Waves referenced outside of the cache, e.g. playing, are never evicted.
+VOID TestWaveCacheReferenced() {
+    WAVECACHEPTR cache = InitializeWaveCache(CACHE_TEST_WAVES * CACHE_TEST_SIZE, 2, 0, FALSE);
+    if (!CHECK(cache != NULL)) { return; }
+
+    WAVEPTR playing = OpenCachedWave(cache, CacheTestPaths[0], JOBPRIORITY_LOAD);
+    CHECK(playing != NULL);
+
+    UseCacheTestWave(cache, 1);
+    UseCacheTestWave(cache, 2);
+
+    CHECK(cache->nCount == 2);
+    CHECK(IsCacheTestWaveCached(cache, 0) && !IsCacheTestWaveCached(cache, 1) && IsCacheTestWaveCached(cache, 2));
+
+    // With every entry referenced, the new wave is handed out without being cached.
+    WAVEPTR next = OpenCachedWave(cache, CacheTestPaths[2], JOBPRIORITY_LOAD);
+    WAVEPTR other = OpenCachedWave(cache, CacheTestPaths[3], JOBPRIORITY_LOAD);
+
+    CHECK(other != NULL);
+    CHECK(cache->nCount == 2 && !IsCacheTestWaveCached(cache, 3));
+    CHECK(IsCacheTestWaveCached(cache, 0) && IsCacheTestWaveCached(cache, 2));
+
+    ReleaseWave(other);
+    ReleaseWave(next);
+    ReleaseWave(playing);
+    ReleaseWaveCache(cache);
+}
+
+// A file that changed size or modification time since it was cached is opened anew.
+VOID TestWaveCacheStale() {
+    WAVECACHEPTR cache = InitializeWaveCache(CACHE_TEST_WAVES * CACHE_TEST_SIZE, CACHE_TEST_WAVES, 0, FALSE);
+    if (!CHECK(cache != NULL)) { return; }
+
+    WAVEPTR cached = OpenCachedWave(cache, CacheTestPaths[0], JOBPRIORITY_LOAD);
+
+    if (CHECK(cached != NULL) && CHECK(WriteCacheTestWave(0, 2 * CACHE_TEST_SIZE))) {
+        WAVEPTR resized = OpenCachedWave(cache, CacheTestPaths[0], JOBPRIORITY_LOAD);
+
+        CHECK(resized != NULL && resized != cached);
+        CHECK(GetWaveMemorySize(resized) == 2 * CACHE_TEST_SIZE);
+        CHECK(cache->nCount == 1 && cache->lpEntries[0].lpWave == resized);
+
+        // Same size, later modification time.
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        HANDLE file = CreateFileA(CacheTestPaths[0], FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (CHECK(file != INVALID_HANDLE_VALUE)
+            && CHECK(GetFileAttributesExA(CacheTestPaths[0], GetFileExInfoStandard, &data))) {
+            ULARGE_INTEGER time;
+            time.LowPart = data.ftLastWriteTime.dwLowDateTime;
+            time.HighPart = data.ftLastWriteTime.dwHighDateTime;
+            time.QuadPart += 10000000;
+
+            data.ftLastWriteTime.dwLowDateTime = time.LowPart;
+            data.ftLastWriteTime.dwHighDateTime = time.HighPart;
+
+            CONST BOOL touched = CHECK(SetFileTime(file, NULL, NULL, &data.ftLastWriteTime));
+            CloseHandle(file);
+
+            if (touched) {
+                WAVEPTR touchedWave = OpenCachedWave(cache, CacheTestPaths[0], JOBPRIORITY_LOAD);
+
+                CHECK(touchedWave != NULL && touchedWave != resized);
+                CHECK(cache->nCount == 1 && cache->lpEntries[0].lpWave == touchedWave);
+
+                ReleaseWave(touchedWave);
+            }
+        }
+
+        ReleaseWave(resized);
+    }
+
+    ReleaseWave(cached);
+    ReleaseWaveCache(cache);
+
+    CHECK(WriteCacheTestWave(0, CACHE_TEST_SIZE));
+}
+
+VOID RunCacheTests() {
+    for (UINT32 i = 0; i < ARRAYSIZE(CacheTestSamples); i++) {
+        CacheTestSamples[i] = (SHORT)(i * 31);
+    }
+
+    BOOL written = TRUE;
+    for (UINT32 i = 0; i < CACHE_TEST_WAVES; i++) {
+        CHAR name[16];
+        snprintf(name, sizeof(name), "cache%u", i);
+
+        GetTestWavePath(CacheTestPaths[i], name);
+        written &= CHECK(WriteCacheTestWave(i, CACHE_TEST_SIZE));
+    }
+
+    if (written) {
+        TestWaveCacheOrder();
+        TestWaveCacheBudget();
+        TestWaveCacheReferenced();
+        TestWaveCacheStale();
+    }
+
+    for (UINT32 i = 0; i < CACHE_TEST_WAVES; i++) {
+        DeleteFileA(CacheTestPaths[i]);
+    }
+}
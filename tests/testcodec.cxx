@@ -0,0 +1,373 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+
+#include "codec.hxx"
+#include "tests.hxx"
+
+#include <ks.h>
+#include <ksmedia.h>
+
+#define CODEC_TEST_SAMPLES      (256 * 4 + 13)
+#define CODEC_BENCH_SAMPLES     (8000 * 60)
+
+BYTE CodecTestInput[CODEC_BENCH_SAMPLES];
+SHORT CodecTestOutput[CODEC_BENCH_SAMPLES];
+
+// ITU-T G.711 expansion, bit by bit as in the reference decoder.
+SHORT ExpandTestMuLaw(BYTE bValue) {
+    CONST INT value = ~bValue & 0xFF;
+    CONST INT magnitude = ((((value & 0x0F) << 3) + 0x84) << ((value >> 4) & 7)) - 0x84;
+
+    return (SHORT)((value & 0x80) ? -magnitude : magnitude);
+}
+
+SHORT ExpandTestALaw(BYTE bValue) {
+    CONST INT value = bValue ^ 0x55;
+    CONST INT segment = (value >> 4) & 7;
+    CONST INT mantissa = value & 0x0F;
+
+    CONST INT magnitude = segment == 0
+        ? (mantissa << 4) + 8 : ((mantissa << 4) + 0x108) << (segment - 1);
+
+    return (SHORT)((value & 0x80) ? magnitude : -magnitude);
+}
+
+BOOL InitializeCodecTest(WAVECODECPTR lpCodec, WORD wFormatTag) {
+    WAVEFORMATEX source, output;
+    ZeroMemory(&source, sizeof(WAVEFORMATEX));
+
+    source.wFormatTag = wFormatTag;
+    source.nChannels = 1;
+    source.nSamplesPerSec = 8000;
+    source.nAvgBytesPerSec = 8000;
+    source.nBlockAlign = 1;
+    source.wBitsPerSample = 8;
+
+    return InitializeWaveCodec(lpCodec, &source, sizeof(WAVEFORMATEX), &output);
+}
+
+// Every code expands as in the reference, in vector lanes and in the table tail alike,
+// whatever the alignment of the first sample.
+VOID TestCodecG711(WORD wFormatTag) {
+    WAVECODEC codec;
+    if (!CHECK(InitializeCodecTest(&codec, wFormatTag))) { return; }
+
+    for (UINT32 i = 0; i < CODEC_TEST_SAMPLES; i++) {
+        CodecTestInput[i] = (BYTE)(i * 7 + i / 256);
+    }
+
+    for (DWORD offset = 0; offset < 16; offset++) {
+        CONST DWORD count = CODEC_TEST_SAMPLES - offset;
+        DecodeWaveFrames(&codec, CodecTestInput, CODEC_TEST_SAMPLES, offset, count, CodecTestOutput);
+
+        for (DWORD i = 0; i < count; i++) {
+            CONST BYTE code = CodecTestInput[offset + i];
+            CONST SHORT expected = wFormatTag == WAVE_FORMAT_MULAW ? ExpandTestMuLaw(code) : ExpandTestALaw(code);
+
+            if (!CHECK(CodecTestOutput[i] == expected)) { break; }
+        }
+    }
+
+    ReleaseWaveCodec(&codec);
+}
+
+// Known values at the ends of the range.
+VOID TestCodecG711Limits() {
+    CONST BYTE input[] = { 0x00, 0x7F, 0x80, 0xFF, 0xD5, 0x55, 0xAA, 0x2A };
+    SHORT output[ARRAYSIZE(input)];
+
+    WAVECODEC codec;
+    if (CHECK(InitializeCodecTest(&codec, WAVE_FORMAT_MULAW))) {
+        DecodeWaveFrames(&codec, input, sizeof(input), 0, 4, output);
+        CHECK(output[0] == -32124 && output[1] == 0 && output[2] == 32124 && output[3] == 0);
+        ReleaseWaveCodec(&codec);
+    }
+
+    if (CHECK(InitializeCodecTest(&codec, WAVE_FORMAT_ALAW))) {
+        DecodeWaveFrames(&codec, input, sizeof(input), 4, 4, output);
+        CHECK(output[0] == 8 && output[1] == -8 && output[2] == 32256 && output[3] == -32256);
+        ReleaseWaveCodec(&codec);
+    }
+}
+
+BOOL InitializeExtensibleCodecTest(WAVECODECPTR lpCodec, CONST GUID* lpSubFormat, WORD wBitsPerSample,
+    DWORD dwSourceSize, LPWAVEFORMATEX lpOutput) {
+    WAVEFORMATEXTENSIBLE source;
+    ZeroMemory(&source, sizeof(WAVEFORMATEXTENSIBLE));
+
+    source.Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+    source.Format.nChannels = 2;
+    source.Format.nSamplesPerSec = 48000;
+    source.Format.wBitsPerSample = wBitsPerSample;
+    source.Format.nBlockAlign = 2 * (wBitsPerSample >> 3);
+    source.Format.nAvgBytesPerSec = 48000 * source.Format.nBlockAlign;
+    source.Format.cbSize = sizeof(WAVEFORMATEXTENSIBLE) - sizeof(WAVEFORMATEX);
+    source.Samples.wValidBitsPerSample = wBitsPerSample;
+    source.dwChannelMask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+    source.SubFormat = *lpSubFormat;
+
+    return InitializeWaveCodec(lpCodec, &source.Format, dwSourceSize, lpOutput);
+}
+
+// Extensible PCM plays as plain PCM, other subformats and truncated formats are rejected.
+VOID TestCodecExtensible() {
+    WAVECODEC codec;
+    WAVEFORMATEX output;
+
+    if (CHECK(InitializeExtensibleCodecTest(&codec, &KSDATAFORMAT_SUBTYPE_PCM, 24, sizeof(WAVEFORMATEXTENSIBLE), &output))) {
+        CHECK(codec.wfxSource.wFormatTag == WAVE_FORMAT_PCM);
+        CHECK(output.wFormatTag == WAVE_FORMAT_PCM && output.wBitsPerSample == 24 && output.nBlockAlign == 6);
+
+        CONST BYTE input[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+        BYTE frames[sizeof(input)];
+
+        CHECK(GetWaveCodecFrames(&codec, sizeof(input)) == 2);
+        DecodeWaveFrames(&codec, input, sizeof(input), 1, 1, frames);
+        CHECK(memcmp(frames, &input[6], 6) == 0);
+
+        ReleaseWaveCodec(&codec);
+    }
+
+    CHECK(!InitializeExtensibleCodecTest(&codec, &KSDATAFORMAT_SUBTYPE_PCM, 24, sizeof(WAVEFORMATEX), &output));
+
+    GUID unknown = KSDATAFORMAT_SUBTYPE_PCM;
+    unknown.Data1 = WAVE_FORMAT_MULAW;
+    CHECK(!InitializeExtensibleCodecTest(&codec, &unknown, 8, sizeof(WAVEFORMATEXTENSIBLE), &output));
+}
+
+// Float samples become 32-bit PCM, rounded, clipped past full scale and silent for NaNs,
+// in vector lanes and in the tail alike.
+VOID TestCodecFloat() {
+    CONST float input[] = {
+        0.0f, 0.5f, -0.5f, -1.0f, 1.0f, 2.0f, -2.0f, 0.001f, -0.25f, NAN, 0.75f };
+    CONST INT expected[] = {
+        0, 1073741824, -1073741824, (-2147483647 - 1), 2147483520, 2147483520, (-2147483647 - 1),
+        2147484, -536870912, 0, 1610612736 };
+
+    INT output[ARRAYSIZE(input)];
+
+    WAVECODEC codec;
+    WAVEFORMATEX format;
+
+    if (CHECK(InitializeExtensibleCodecTest(&codec, &KSDATAFORMAT_SUBTYPE_IEEE_FLOAT, 32, sizeof(WAVEFORMATEXTENSIBLE), &format))) {
+        CHECK(format.wFormatTag == WAVE_FORMAT_PCM && format.wBitsPerSample == 32 && format.nBlockAlign == 8);
+
+        // Odd number of samples with stereo frames, so decode the frames the samples fill.
+        DecodeWaveFrames(&codec, input, sizeof(input), 0, ARRAYSIZE(input) / 2, output);
+        CHECK(memcmp(output, expected, (ARRAYSIZE(input) - 1) * sizeof(INT)) == 0);
+
+        DecodeWaveFrames(&codec, input, sizeof(input), 1, 3, output);
+        CHECK(memcmp(output, &expected[2], 6 * sizeof(INT)) == 0);
+
+        ReleaseWaveCodec(&codec);
+    }
+
+    // Plain float format, mono, so that every sample goes through.
+    WAVEFORMATEX source;
+    ZeroMemory(&source, sizeof(WAVEFORMATEX));
+    source.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
+    source.nChannels = 1;
+    source.nSamplesPerSec = 48000;
+    source.wBitsPerSample = 32;
+    source.nBlockAlign = sizeof(float);
+    source.nAvgBytesPerSec = 48000 * sizeof(float);
+
+    if (CHECK(InitializeWaveCodec(&codec, &source, sizeof(WAVEFORMATEX), &format))) {
+        DecodeWaveFrames(&codec, input, sizeof(input), 0, ARRAYSIZE(input), output);
+        CHECK(memcmp(output, expected, sizeof(expected)) == 0);
+
+        ReleaseWaveCodec(&codec);
+    }
+
+    // Doubles are not supported.
+    source.wBitsPerSample = 64;
+    source.nBlockAlign = sizeof(double);
+    CHECK(!InitializeWaveCodec(&codec, &source, sizeof(WAVEFORMATEX), &format));
+}
+
+// Blocks encoded by hand and decoded by an independent reference: saturation at both
+// ends, index and delta limits, an out-of-range predictor, and a partial last block.
+CONST BYTE ImaMonoTestBlocks[] = {
+    0x00, 0x7D, 0x50, 0x00, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77, 0x77,
+    0x77, 0x77, 0x77, 0x77, 0x9C, 0xFF, 0x03, 0x00, 0x08, 0x80, 0x00, 0x88, 0x19, 0xF0, 0x2A, 0xB3,
+    0x4C, 0xD5, 0x6E, 0xF7, 0x08, 0x80, 0x11, 0x99, 0x00, 0x00, 0x0A, 0x00, 0x12, 0x34, 0x56, 0x78,
+    0x9A, 0xBC, 0xDE, 0xF0,
+};
+CONST SHORT ImaMonoTestFrames[] = {
+    32000, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767,
+    32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767,
+    32767, 32767, 32767, 32767, 32767, 32767, 32767, -100, -101, -100, -99, -99, -99, -99, -99, -99,
+    -100, -99, -99, -110, -120, -112, -102, -112, -124, -110, -88, -118, -173, -76, 123, -307, -368,
+    -312, -261, -307, -181, -67, -170, -264, 0, 11, 17, 35, 50, 77, 118, 113, 189, 134, 104, 22,
+    -55, -185, -380, -354, -709,
+};
+CONST BYTE ImaStereoTestBlocks[] = {
+    0xE8, 0x03, 0x14, 0x00, 0x30, 0xF8, 0x28, 0x00, 0x21, 0x43, 0x65, 0x07, 0x9A, 0xBC, 0xDE, 0x8F,
+    0x70, 0x81, 0x92, 0xA3, 0x0F, 0x1E, 0x2D, 0x3C, 0x00, 0x83, 0x3C, 0x00, 0x00, 0x7D, 0x3C, 0x00,
+    0xFF, 0xFF, 0xFF, 0xFF, 0x77, 0x77, 0x77, 0x77, 0x00, 0x00, 0x00, 0x00, 0x88, 0x88, 0x88, 0x88,
+};
+CONST SHORT ImaStereoTestFrames[] = {
+    1000, -2000, 1018, -2210, 1045, -2324, 1080, -2637, 1121, -2931, 1182, -3429, 1289, -4177, 1509,
+    -5669, 1540, -5882, 1568, -8792, 1959, -8377, 2127, -13291, 2076, -11283, 2307, -17979, 2181,
+    -13522, 2448, -20816, 2275, -13953, -32000, 32000, -32768, 32767, -32768, 32767, -32768, 32767,
+    -32768, 32767, -32768, 32767, -32768, 32767, -32768, 32767, -32768, 32767, -28673, 28672,
+    -24949, 24948, -21564, 21563, -18487, 18486, -15689, 15688, -13146, 13145, -10834, 10833, -8732,
+    8731,
+};
+CONST BYTE MsMonoTestBlocks[] = {
+    0x01, 0xF4, 0x01, 0xE8, 0x03, 0x84, 0x03, 0x12, 0x7F, 0x80, 0xE9, 0x34, 0x77, 0x0C, 0xA5, 0x09,
+    0x10, 0x00, 0x00, 0x7D, 0x18, 0x79, 0x77, 0x77, 0x77, 0x77, 0x10, 0x01, 0x88, 0x88, 0x04, 0x40,
+    0x00, 0x48, 0xF4, 0xE4, 0xF3, 0x3D, 0xC2, 0x5B,
+};
+CONST SHORT MsMonoTestFrames[] = {
+    900, 1000, 1600, 3098, 7417, 10770, 7187, 3604, -4651, -27592, -32768, -19864, 30980, 32767,
+    32767, -32768, -32768, 32767, 31000, 32000, 21018, 3449, -13129, -21703, -17680, 1353, 32767,
+    32767, 32767, 20479, 1663, -3499, -32768, -32768, -32768, -32768, -3100, -3000, -2620, -2627,
+    -2666, -2377, -1958, -2265,
+};
+CONST BYTE MsStereoTestBlocks[] = {
+    0x03, 0x05, 0x28, 0x00, 0x2C, 0x01, 0x0C, 0xFE, 0xD0, 0x07, 0x70, 0xFE, 0x34, 0x08, 0x1F, 0xE2,
+    0x73, 0x08, 0x9C, 0x45, 0xB6, 0xD1, 0x00, 0x02, 0xE8, 0x03, 0x14, 0x00, 0xE0, 0x2E, 0xF9, 0xFF,
+    0xF8, 0x2A, 0xF8, 0xFF, 0x70, 0x07, 0x99, 0x11, 0xF1, 0x1F, 0x44, 0xCC, 0x06, 0x01, 0x10, 0x00,
+    0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x7F,
+};
+CONST SHORT MsStereoTestFrames[] = {
+    -400, 2100, -500, 2000, -435, 1587, -521, 1764, -282, 2603, -341, 1516, -788, -1983, -44, -909,
+    -1175, 7424, -1795, 16560, 11000, -8, 12000, -7, 19000, 0, 19000, 119, 3922, -280, 9088, 95,
+    4447, 85, 8616, -76, 23596, 272, 5632, -324, 0, 0, 0, 0, 112, -16, 437, -48,
+};
+
+CONST ADPCMCOEFSET MsTestCoefficients[] = {
+    { 256, 0 }, { 512, -256 }, { 0, 0 }, { 192, 64 }, { 240, 0 }, { 460, -208 }, { 392, -232 }
+};
+
+BOOL InitializeAdpcmCodecTest(WAVECODECPTR lpCodec, WORD wFormatTag, WORD nChannels, WORD nBlockAlign) {
+    BYTE format[sizeof(ADPCMWAVEFORMAT) + ARRAYSIZE(MsTestCoefficients) * sizeof(ADPCMCOEFSET)];
+    ZeroMemory(format, sizeof(format));
+
+    ADPCMWAVEFORMAT* source = (ADPCMWAVEFORMAT*)format;
+    source->wfx.wFormatTag = wFormatTag;
+    source->wfx.nChannels = nChannels;
+    source->wfx.nSamplesPerSec = 8000;
+    source->wfx.nBlockAlign = nBlockAlign;
+    source->wfx.wBitsPerSample = 4;
+
+    if (wFormatTag == WAVE_FORMAT_ADPCM) {
+        source->wfx.cbSize = sizeof(format) - sizeof(WAVEFORMATEX);
+        source->wNumCoef = ARRAYSIZE(MsTestCoefficients);
+        CopyMemory(source->aCoef, MsTestCoefficients, sizeof(MsTestCoefficients));
+    }
+
+    WAVEFORMATEX output;
+    return InitializeWaveCodec(lpCodec, &source->wfx,
+        wFormatTag == WAVE_FORMAT_ADPCM ? sizeof(format) : sizeof(WAVEFORMATEX), &output);
+}
+
+// The whole stream decodes to the reference at once and in reads that start and end
+// in the middle of blocks.
+VOID TestCodecAdpcm(WORD wFormatTag, WORD nChannels, WORD nBlockAlign,
+    CONST BYTE* lpBlocks, DWORD dwSize, CONST SHORT* lpFrames, DWORD dwSamples) {
+    WAVECODEC codec;
+    if (!CHECK(InitializeAdpcmCodecTest(&codec, wFormatTag, nChannels, nBlockAlign))) { return; }
+
+    CONST DWORD frames = dwSamples / nChannels;
+    if (CHECK(GetWaveCodecFrames(&codec, dwSize) == frames)) {
+        DecodeWaveFrames(&codec, lpBlocks, dwSize, 0, frames, CodecTestOutput);
+        CHECK(memcmp(CodecTestOutput, lpFrames, dwSamples * sizeof(SHORT)) == 0);
+
+        for (DWORD offset = 0; offset < frames; offset += 7) {
+            CONST DWORD count = min(7, frames - offset);
+            DecodeWaveFrames(&codec, lpBlocks, dwSize, offset, count, CodecTestOutput);
+
+            if (!CHECK(memcmp(CodecTestOutput,
+                &lpFrames[offset * nChannels], count * nChannels * sizeof(SHORT)) == 0)) { break; }
+        }
+    }
+
+    ReleaseWaveCodec(&codec);
+}
+
+// A block of more than 65535 frames is counted and read in full.
+VOID TestCodecAdpcmLargeBlock() {
+    CONST DWORD align = 4 + 32768 / 4 * 4;
+    CONST DWORD frames = 1 + 32768 * 2;
+
+    WAVECODEC codec;
+    if (!CHECK(InitializeAdpcmCodecTest(&codec, WAVE_FORMAT_IMA_ADPCM, 1, (WORD)align))) { return; }
+
+    ZeroMemory(CodecTestInput, 2 * align);
+    CodecTestInput[0] = 0x34; CodecTestInput[1] = 0x12;
+    CodecTestInput[align] = 0xCC; CodecTestInput[align + 1] = 0xED;
+
+    if (CHECK(GetWaveCodecFrames(&codec, 2 * align) == 2 * frames)) {
+        DecodeWaveFrames(&codec, CodecTestInput, 2 * align, frames - 1, 2, CodecTestOutput);
+        CHECK(CodecTestOutput[0] == 0x1234 && CodecTestOutput[1] == (SHORT)0xEDCC);
+    }
+
+    ReleaseWaveCodec(&codec);
+}
+
+// Cost of expanding a minute of 8 kHz audio.
+VOID BenchmarkCodecG711(WORD wFormatTag) {
+    WAVECODEC codec;
+    if (!InitializeCodecTest(&codec, wFormatTag)) { return; }
+
+    for (UINT32 i = 0; i < CODEC_BENCH_SAMPLES; i++) {
+        CodecTestInput[i] = (BYTE)(i * 7);
+    }
+
+    CONST double start = GetTestTime();
+    for (UINT32 r = 0; r < 16; r++) {
+        DecodeWaveFrames(&codec, CodecTestInput, CODEC_BENCH_SAMPLES, 0, CODEC_BENCH_SAMPLES, CodecTestOutput);
+    }
+
+    CONST double elapsed = GetTestTime() - start;
+    printf("%s expansion: %.2f ns per sample.\n", wFormatTag == WAVE_FORMAT_MULAW ? "Mu-law" : "A-law",
+        elapsed * 1000000000.0 / (16.0 * CODEC_BENCH_SAMPLES));
+
+    ReleaseWaveCodec(&codec);
+}
+
+VOID RunCodecTests() {
+    TestCodecG711(WAVE_FORMAT_MULAW);
+    TestCodecG711(WAVE_FORMAT_ALAW);
+    TestCodecG711Limits();
+
+    TestCodecAdpcm(WAVE_FORMAT_IMA_ADPCM, 1, 20, ImaMonoTestBlocks, sizeof(ImaMonoTestBlocks),
+        ImaMonoTestFrames, ARRAYSIZE(ImaMonoTestFrames));
+    TestCodecAdpcm(WAVE_FORMAT_IMA_ADPCM, 2, 24, ImaStereoTestBlocks, sizeof(ImaStereoTestBlocks),
+        ImaStereoTestFrames, ARRAYSIZE(ImaStereoTestFrames));
+    TestCodecAdpcm(WAVE_FORMAT_ADPCM, 1, 15, MsMonoTestBlocks, sizeof(MsMonoTestBlocks),
+        MsMonoTestFrames, ARRAYSIZE(MsMonoTestFrames));
+    TestCodecAdpcm(WAVE_FORMAT_ADPCM, 2, 22, MsStereoTestBlocks, sizeof(MsStereoTestBlocks),
+        MsStereoTestFrames, ARRAYSIZE(MsStereoTestFrames));
+    TestCodecAdpcmLargeBlock();
+    TestCodecExtensible();
+    TestCodecFloat();
+
+    if (IsBenchmarkRequested()) {
+        BenchmarkCodecG711(WAVE_FORMAT_MULAW);
+        BenchmarkCodecG711(WAVE_FORMAT_ALAW);
+    }
+}
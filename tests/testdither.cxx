@@ -0,0 +1,240 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "tests.hxx"
+#include "dither.hxx"
+
+#define DITHER_TEST_FRAMES      32768
+#define DITHER_TEST_CHANNELS    2
+#define DITHER_TEST_RATE        44100
+
+#define DITHER_BENCH_RATE       192000
+#define DITHER_BENCH_SECONDS    10
+#define DITHER_BENCH_PERIOD     1920        // In Frames, 10 ms at 192 kHz.
+
+DITHER TestDither;
+
+INT DitherTestInput[DITHER_TEST_FRAMES * DITHER_TEST_CHANNELS];
+BYTE DitherTestPacked[DITHER_TEST_FRAMES * DITHER_TEST_CHANNELS * 3];
+SHORT DitherTestOutput[DITHER_TEST_FRAMES * DITHER_TEST_CHANNELS];
+SHORT DitherTestReference[DITHER_TEST_FRAMES * DITHER_TEST_CHANNELS];
+
+VOID SetDitherTestFormat(LPWAVEFORMATEX lpFormat, WORD wBitsPerSample, DWORD dwSamplesPerSec) {
+    ZeroMemory(lpFormat, sizeof(WAVEFORMATEX));
+
+    lpFormat->wFormatTag = WAVE_FORMAT_PCM;
+    lpFormat->nChannels = DITHER_TEST_CHANNELS;
+    lpFormat->nSamplesPerSec = dwSamplesPerSec;
+    lpFormat->wBitsPerSample = wBitsPerSample;
+    lpFormat->nBlockAlign = DITHER_TEST_CHANNELS * (wBitsPerSample >> 3);
+    lpFormat->nAvgBytesPerSec = dwSamplesPerSec * lpFormat->nBlockAlign;
+}
+
+// A -40 dBFS sine in each channel, with the low byte clear so that it packs into 24 bits as is.
+VOID FillDitherTestInput() {
+    for (UINT32 i = 0; i < DITHER_TEST_FRAMES; i++) {
+        for (UINT32 c = 0; c < DITHER_TEST_CHANNELS; c++) {
+            CONST double phase = 2.0 * 3.14159265358979 * 1000.0 * (c + 1) * i / DITHER_TEST_RATE;
+            CONST INT sample = (INT)(sin(phase) * 0.01 * 2147483647.0) & ~0xFF;
+            BYTE* packed = &DitherTestPacked[(i * DITHER_TEST_CHANNELS + c) * 3];
+
+            DitherTestInput[i * DITHER_TEST_CHANNELS + c] = sample;
+
+            packed[0] = (BYTE)(sample >> 8);
+            packed[1] = (BYTE)(sample >> 16);
+            packed[2] = (BYTE)(sample >> 24);
+        }
+    }
+}
+
+// Requantization error of a channel, in 16-bit steps.
+double GetDitherTestError(UINT32 nFrame, UINT32 nChannel) {
+    CONST UINT32 sample = nFrame * DITHER_TEST_CHANNELS + nChannel;
+    return DitherTestOutput[sample] - DitherTestInput[sample] / 65536.0;
+}
+
+// Power of the error around the frequency, averaged over a few bins, in dB.
+double GetDitherTestBand(UINT32 nChannel, double fFrequency) {
+    double power = 0.0;
+
+    for (INT b = -4; b <= 4; b++) {
+        CONST double step = 2.0 * 3.14159265358979 * (fFrequency + b * 50.0) / DITHER_TEST_RATE;
+
+        double re = 0.0, im = 0.0;
+        for (UINT32 i = 0; i < DITHER_TEST_FRAMES; i++) {
+            CONST double error = GetDitherTestError(i, nChannel);
+            re += error * cos(step * i);
+            im += error * sin(step * i);
+        }
+
+        power += (re * re + im * im) / DITHER_TEST_FRAMES;
+    }
+
+    return 10.0 * log10(power / 9.0);
+}
+
+// Dithers the whole input in uneven pieces, the state has to carry over between them.
+VOID RunDitherTestPass(LPCVOID lpInput, WORD wBitsPerSample, DITHERSHAPE dwShape, SHORT* lpOutput) {
+    WAVEFORMATEX format;
+    SetDitherTestFormat(&format, wBitsPerSample, DITHER_TEST_RATE);
+
+    CHECK(InitializeDither(&TestDither, &format, dwShape));
+
+    CONST BYTE* input = (CONST BYTE*)lpInput;
+    for (UINT32 i = 0; i < DITHER_TEST_FRAMES;) {
+        CONST UINT32 frames = min(DITHER_TEST_FRAMES - i, 333 + i % 517);
+        DitherFrames(&TestDither, &input[i * format.nBlockAlign], frames, &lpOutput[i * DITHER_TEST_CHANNELS]);
+        i += frames;
+    }
+}
+
+VOID TestDitherSupport() {
+    WAVEFORMATEX format;
+
+    SetDitherTestFormat(&format, 16, DITHER_TEST_RATE);
+    CHECK(!IsDitherSupported(&format));
+
+    SetDitherTestFormat(&format, 24, DITHER_TEST_RATE);
+    CHECK(IsDitherSupported(&format));
+
+    SetDitherTestFormat(&format, 32, DITHER_TEST_RATE);
+    CHECK(IsDitherSupported(&format));
+
+    format.wFormatTag = WAVE_FORMAT_ADPCM;
+    CHECK(!IsDitherSupported(&format));
+}
+
+// Flat TPDF dither adds 1/6 of a step squared to the 1/12 of the rounding itself,
+// with no offset and no trace of the signal.
+VOID TestDitherFlatNoise() {
+    RunDitherTestPass(DitherTestInput, 32, DITHERSHAPE_NONE, DitherTestOutput);
+
+    for (UINT32 c = 0; c < DITHER_TEST_CHANNELS; c++) {
+        double mean = 0.0, power = 0.0;
+        for (UINT32 i = 0; i < DITHER_TEST_FRAMES; i++) {
+            CONST double error = GetDitherTestError(i, c);
+            mean += error;
+            power += error * error;
+        }
+
+        mean /= DITHER_TEST_FRAMES;
+        power /= DITHER_TEST_FRAMES;
+
+        CHECK(fabs(mean) < 0.01);
+        CHECK(0.22 < power && power < 0.28);
+    }
+}
+
+// Shaped noise has to sit below the flat one in the low band and above it at the top.
+VOID TestDitherShapedNoise() {
+    CONST double low = 300.0, mid = 4000.0, high = 18000.0;
+
+    RunDitherTestPass(DitherTestInput, 32, DITHERSHAPE_NONE, DitherTestOutput);
+    CONST double flatLow = GetDitherTestBand(0, low);
+    CONST double flatMid = GetDitherTestBand(0, mid);
+    CONST double flatHigh = GetDitherTestBand(0, high);
+
+    RunDitherTestPass(DitherTestInput, 32, DITHERSHAPE_FIRST_ORDER, DitherTestOutput);
+    CHECK(GetDitherTestBand(0, low) < flatLow - 10.0);
+    CHECK(flatHigh < GetDitherTestBand(0, high));
+
+    RunDitherTestPass(DitherTestInput, 32, DITHERSHAPE_SECOND_ORDER, DitherTestOutput);
+    CHECK(GetDitherTestBand(0, low) < flatLow - 20.0);
+    CHECK(flatHigh + 6.0 < GetDitherTestBand(0, high));
+
+    RunDitherTestPass(DitherTestInput, 32, DITHERSHAPE_LIPSHITZ, DitherTestOutput);
+    CHECK(GetDitherTestBand(0, mid) < flatMid - 6.0);
+    CHECK(flatHigh + 6.0 < GetDitherTestBand(0, high));
+}
+
+// 24 and 32-bit sources of the same signal have to come out the same, and so
+// does a single call versus many uneven ones.
+VOID TestDitherConsistency() {
+    RunDitherTestPass(DitherTestInput, 32, DITHERSHAPE_LIPSHITZ, DitherTestReference);
+    RunDitherTestPass(DitherTestPacked, 24, DITHERSHAPE_LIPSHITZ, DitherTestOutput);
+
+    CHECK(memcmp(DitherTestReference, DitherTestOutput, sizeof(DitherTestOutput)) == 0);
+
+    WAVEFORMATEX format;
+    SetDitherTestFormat(&format, 32, DITHER_TEST_RATE);
+    CHECK(InitializeDither(&TestDither, &format, DITHERSHAPE_LIPSHITZ));
+    DitherFrames(&TestDither, DitherTestInput, DITHER_TEST_FRAMES, DitherTestOutput);
+
+    CHECK(memcmp(DitherTestReference, DitherTestOutput, sizeof(DitherTestOutput)) == 0);
+}
+
+// Full scale input must saturate, not wrap around.
+VOID TestDitherSaturation() {
+    WAVEFORMATEX format;
+    SetDitherTestFormat(&format, 32, DITHER_TEST_RATE);
+
+    INT input[DITHER_TEST_CHANNELS * 64];
+    SHORT output[DITHER_TEST_CHANNELS * 64];
+
+    for (UINT32 i = 0; i < ARRAYSIZE(input); i++) {
+        input[i] = (i & 1) ? 0x7FFFFFFF : (INT)0x80000000;
+    }
+
+    CHECK(InitializeDither(&TestDither, &format, DITHERSHAPE_SECOND_ORDER));
+    DitherFrames(&TestDither, input, ARRAYSIZE(input) / DITHER_TEST_CHANNELS, output);
+
+    for (UINT32 i = 0; i < ARRAYSIZE(output); i++) {
+        if (!CHECK((i & 1) ? 32000 < output[i] : output[i] < -32000)) { break; }
+    }
+}
+
+// Cost of dithering 192 kHz stereo in 10 ms periods, as in the audio thread.
+VOID BenchmarkDither(WORD wBitsPerSample) {
+    WAVEFORMATEX format;
+    SetDitherTestFormat(&format, wBitsPerSample, DITHER_BENCH_RATE);
+    InitializeDither(&TestDither, &format, DITHERSHAPE_SECOND_ORDER);
+
+    CONST BYTE* input = wBitsPerSample == 32 ? (CONST BYTE*)DitherTestInput : DitherTestPacked;
+
+    CONST double start = GetTestTime();
+    for (UINT32 i = 0; i < DITHER_BENCH_RATE * DITHER_BENCH_SECONDS; i += DITHER_BENCH_PERIOD) {
+        CONST UINT32 offset = i % (DITHER_TEST_FRAMES - DITHER_BENCH_PERIOD);
+        DitherFrames(&TestDither, &input[offset * format.nBlockAlign], DITHER_BENCH_PERIOD, DitherTestOutput);
+    }
+
+    CONST double elapsed = GetTestTime() - start;
+    printf("Dither %u-bit, 192 kHz stereo: %.3f%% of a core.\n",
+        wBitsPerSample, 100.0 * elapsed / DITHER_BENCH_SECONDS);
+}
+
+VOID RunDitherTests() {
+    FillDitherTestInput();
+
+    TestDitherSupport();
+    TestDitherFlatNoise();
+    TestDitherShapedNoise();
+    TestDitherConsistency();
+    TestDitherSaturation();
+
+    if (IsBenchmarkRequested()) {
+        BenchmarkDither(24);
+        BenchmarkDither(32);
+    }
+}
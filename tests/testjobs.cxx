@@ -0,0 +1,232 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+#include "jobs.hxx"
+#include "tests.hxx"
+
+#define JOB_TEST_COUNT          64
+
+typedef struct JobTestState {
+    LONG                    nRuns;
+    BOOL                    aCancelled[2];      // Whether the job was cancelled on each run.
+    BOOL                    bRenewed;           // Whether renewal took the job out of cancellation.
+} JOBTESTSTATE, * JOBTESTSTATEPTR;
+
+// Workers wait on the gate once all of them are blocked.
+HANDLE JobTestGate;
+HANDLE JobTestBlocked;
+volatile LONG JobTestBlockedWorkers;
+
+// Parameters of the jobs in the order they ran, and the event set when the last one did.
+LONG JobTestOrder[JOB_TEST_COUNT];
+volatile LONG JobTestRuns;
+LONG JobTestExpectedRuns;
+HANDLE JobTestDone;
+
+HANDLE JobTestParentDone;
+BOOL JobTestStolen;
+
+BOOL BlockJobTestWorker(LPVOID lpParameter, JOBPTR lpJob) {
+    if (InterlockedIncrement(&JobTestBlockedWorkers) == TEST_JOB_WORKERS) { SetEvent(JobTestBlocked); }
+
+    WaitForSingleObject(JobTestGate, TEST_TIMEOUT);
+
+    return FALSE;
+}
+
+BOOL RecordJobTestRun(LPVOID lpParameter, JOBPTR lpJob) {
+    CONST LONG run = InterlockedIncrement(&JobTestRuns);
+
+    if (run <= JOB_TEST_COUNT) { JobTestOrder[run - 1] = (LONG)(size_t)lpParameter; }
+    if (run == JobTestExpectedRuns) { SetEvent(JobTestDone); }
+
+    return FALSE;
+}
+
+BOOL CheckJobTestCancellation(LPVOID lpParameter, JOBPTR lpJob) {
+    JOBTESTSTATEPTR state = (JOBTESTSTATEPTR)lpParameter;
+
+    state->aCancelled[state->nRuns] = IsJobCancelled(lpJob);
+
+    if (state->nRuns++ == 0 && state->aCancelled[0]) {
+        RenewJob(lpJob);
+        state->bRenewed = !IsJobCancelled(lpJob);
+
+        // Run once more, to see that the renewal holds.
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+// Children go to the queue of the worker running the parent, which does not return
+// until they are done, so the other worker has to steal them.
+BOOL SubmitJobTestChildren(LPVOID lpParameter, JOBPTR lpJob) {
+    BOOL submitted = TRUE;
+    for (LONG i = 0; i < JOB_TEST_COUNT; i++) {
+        submitted &= SubmitJob(RecordJobTestRun, (LPVOID)(size_t)i, JOBPRIORITY_LOAD);
+    }
+
+    JobTestStolen = submitted && WaitForSingleObject(JobTestDone, TEST_TIMEOUT) == WAIT_OBJECT_0;
+    SetEvent(JobTestParentDone);
+
+    return FALSE;
+}
+
+VOID ResetJobTestRuns(LONG nExpected) {
+    ResetEvent(JobTestDone);
+    JobTestRuns = 0;
+    JobTestExpectedRuns = nExpected;
+}
+
+// Occupies every worker, so that jobs submitted next are left for the calling thread.
+BOOL BlockJobTestWorkers() {
+    ResetEvent(JobTestGate);
+    ResetEvent(JobTestBlocked);
+    JobTestBlockedWorkers = 0;
+
+    for (UINT32 i = 0; i < TEST_JOB_WORKERS; i++) {
+        if (!SubmitJob(BlockJobTestWorker, NULL, JOBPRIORITY_LOAD)) { return FALSE; }
+    }
+
+    return WaitForSingleObject(JobTestBlocked, TEST_TIMEOUT) == WAIT_OBJECT_0;
+}
+
+// Lets the blocked workers go and starts over with new ones, and with metrics at zero.
+VOID RestartJobTestWorkers() {
+    SetEvent(JobTestGate);
+
+    ReleaseJobs();
+    InitializeJobs(TEST_JOB_WORKERS, 0);
+}
+
+// Higher priority goes first, jobs of the same priority run in the order they were submitted.
+VOID TestJobPriority() {
+    if (!CHECK(BlockJobTestWorkers())) {
+        RestartJobTestWorkers();
+        return;
+    }
+
+    ResetJobTestRuns(6);
+
+    for (LONG i = 0; i < 3; i++) {
+        CHECK(SubmitJob(RecordJobTestRun, (LPVOID)(size_t)i, JOBPRIORITY_PREFETCH));
+        CHECK(SubmitJob(RecordJobTestRun, (LPVOID)(size_t)(i + 3), JOBPRIORITY_LOAD));
+    }
+
+    JOBMETRICS metrics;
+    GetJobMetrics(&metrics);
+
+    CHECK(metrics.nPending[JOBPRIORITY_LOAD] == 3 && metrics.nPending[JOBPRIORITY_PREFETCH] == 3);
+
+    while (RunPendingJob()) {}
+
+    if (CHECK(JobTestRuns == 6)) {
+        for (LONG i = 0; i < 6; i++) {
+            CHECK(JobTestOrder[i] == (i + 3) % 6);
+        }
+    }
+
+    RestartJobTestWorkers();
+}
+
+VOID TestJobStealing() {
+    ResetJobTestRuns(JOB_TEST_COUNT);
+    ResetEvent(JobTestParentDone);
+    JobTestStolen = FALSE;
+
+    if (CHECK(SubmitJob(SubmitJobTestChildren, NULL, JOBPRIORITY_LOAD))) {
+        CHECK(WaitForSingleObject(JobTestParentDone, TEST_TIMEOUT) == WAIT_OBJECT_0);
+        CHECK(JobTestStolen);
+    }
+
+    RestartJobTestWorkers();
+}
+
+// Jobs submitted before CancelJobs are cancelled, renewed jobs and the ones submitted after are not.
+VOID TestJobCancellation() {
+    CHECK(!IsJobCancelled(NULL));
+
+    if (!CHECK(BlockJobTestWorkers())) {
+        RestartJobTestWorkers();
+        return;
+    }
+
+    JOBTESTSTATE before, after;
+    ZeroMemory(&before, sizeof(JOBTESTSTATE));
+    ZeroMemory(&after, sizeof(JOBTESTSTATE));
+
+    CHECK(SubmitJob(CheckJobTestCancellation, &before, JOBPRIORITY_LOAD));
+    CancelJobs();
+    CHECK(SubmitJob(CheckJobTestCancellation, &after, JOBPRIORITY_LOAD));
+
+    while (RunPendingJob()) {}
+
+    CHECK(before.nRuns == 2 && before.aCancelled[0] && before.bRenewed && !before.aCancelled[1]);
+    CHECK(after.nRuns == 1 && !after.aCancelled[0]);
+
+    RestartJobTestWorkers();
+}
+
+// Every job is counted once as pending and once as completed, at its own priority.
+VOID TestJobMetrics() {
+    ResetJobTestRuns(JOB_TEST_COUNT);
+
+    for (LONG i = 0; i < JOB_TEST_COUNT; i++) {
+        CHECK(SubmitJob(RecordJobTestRun, (LPVOID)(size_t)i, JOBPRIORITY_PREFETCH));
+    }
+
+    CHECK(WaitForSingleObject(JobTestDone, TEST_TIMEOUT) == WAIT_OBJECT_0);
+
+    // Workers are gone once released, so the counts no longer change.
+    ReleaseJobs();
+
+    JOBMETRICS metrics;
+    GetJobMetrics(&metrics);
+
+    CHECK(metrics.nPending[JOBPRIORITY_LOAD] == 0 && metrics.nPending[JOBPRIORITY_PREFETCH] == 0);
+    CHECK(metrics.nCompleted[JOBPRIORITY_LOAD] == 0 && metrics.nCompleted[JOBPRIORITY_PREFETCH] == JOB_TEST_COUNT);
+
+    CHECK(0 <= metrics.nMaxLatency[JOBPRIORITY_PREFETCH]);
+    CHECK(metrics.nMaxLatency[JOBPRIORITY_PREFETCH] <= metrics.nTotalLatency[JOBPRIORITY_PREFETCH]);
+    CHECK(metrics.nTotalLatency[JOBPRIORITY_PREFETCH] <= (LONGLONG)metrics.nMaxLatency[JOBPRIORITY_PREFETCH] * JOB_TEST_COUNT);
+
+    InitializeJobs(TEST_JOB_WORKERS, 0);
+}
+
+VOID RunJobTests() {
+    JobTestGate = CreateEventA(NULL, TRUE, FALSE, NULL);
+    JobTestBlocked = CreateEventA(NULL, TRUE, FALSE, NULL);
+    JobTestDone = CreateEventA(NULL, TRUE, FALSE, NULL);
+    JobTestParentDone = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+    if (CHECK(JobTestGate != NULL && JobTestBlocked != NULL && JobTestDone != NULL && JobTestParentDone != NULL)) {
+        TestJobPriority();
+        TestJobStealing();
+        TestJobCancellation();
+        TestJobMetrics();
+    }
+
+    if (JobTestGate != NULL) { CloseHandle(JobTestGate); }
+    if (JobTestBlocked != NULL) { CloseHandle(JobTestBlocked); }
+    if (JobTestDone != NULL) { CloseHandle(JobTestDone); }
+    if (JobTestParentDone != NULL) { CloseHandle(JobTestParentDone); }
+}
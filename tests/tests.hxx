@@ -0,0 +1,52 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <windows.h>
+#include <mmreg.h>
+#include <stdio.h>
+
+#define TEST_JOB_WORKERS    2
+#define TEST_TIMEOUT        30000       // In Milliseconds, for background work to complete.
+
+#define CHECK(x) ((x) ? TRUE : ReportTestFailure(__FILE__, __LINE__, #x))
+
+BOOL ReportTestFailure(LPCSTR szFile, INT nLine, LPCSTR szExpression);
+BOOL IsBenchmarkRequested();
+
+double GetTestTime();       // In Seconds
+
+VOID GetTestWavePath(LPSTR lpszPath, LPCSTR lpszName);
+BOOL WriteTestWave(LPCSTR lpszPath, CONST LPWAVEFORMATEX lpFormat,
+    LPCVOID lpSamples, DWORD dwSize, DWORD dwFactFrames);
+BOOL WriteLongTestWave(LPCSTR lpszPath, CONST LPWAVEFORMATEX lpFormat,
+    LPCVOID lpSamples, DWORD dwSamplesSize, DWORD dwSize, DWORD dwFactFrames);
+
+VOID RunCacheTests();
+VOID RunCodecTests();
+VOID RunDitherTests();
+VOID RunJobTests();
+VOID RunScrubTests();
+VOID RunStoreTests();
+VOID RunTimelineTests();
+VOID RunWaveTests();
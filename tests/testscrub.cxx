@@ -0,0 +1,155 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+
+#include "scrub.hxx"
+#include "tests.hxx"
+
+#define SCRUB_TEST_RATE         44100
+#define SCRUB_TEST_CHANNELS     2
+#define SCRUB_TEST_FRAMES       (SCRUB_TEST_RATE * 4)
+
+SCRUB TestScrub;
+
+SHORT ScrubTestSamples[SCRUB_TEST_FRAMES * SCRUB_TEST_CHANNELS];
+SHORT ScrubTestOutput[MAX_SCRUB_GRAIN_SIZE * MAX_SCRUB_CHANNELS];
+
+// A half scale 440 Hz sine, loaded in full.
+WAVEPTR OpenScrubTestWave() {
+    for (UINT32 i = 0; i < SCRUB_TEST_FRAMES; i++) {
+        CONST SHORT sample = (SHORT)(sin(2.0 * 3.14159265358979 * 440.0 * i / SCRUB_TEST_RATE) * 16384.0);
+        for (UINT32 c = 0; c < SCRUB_TEST_CHANNELS; c++) {
+            ScrubTestSamples[i * SCRUB_TEST_CHANNELS + c] = sample;
+        }
+    }
+
+    WAVEFORMATEX format;
+    ZeroMemory(&format, sizeof(WAVEFORMATEX));
+    format.wFormatTag = WAVE_FORMAT_PCM;
+    format.nChannels = SCRUB_TEST_CHANNELS;
+    format.nSamplesPerSec = SCRUB_TEST_RATE;
+    format.wBitsPerSample = 16;
+    format.nBlockAlign = SCRUB_TEST_CHANNELS * sizeof(SHORT);
+    format.nAvgBytesPerSec = SCRUB_TEST_RATE * format.nBlockAlign;
+
+    CHAR path[MAX_PATH];
+    GetTestWavePath(path, "scrub");
+
+    if (!CHECK(WriteTestWave(path, &format, ScrubTestSamples, sizeof(ScrubTestSamples), 0))) { return NULL; }
+
+    WAVEPTR wav = OpenWave(path, 0);
+    if (!CHECK(wav != NULL)) { return NULL; }
+
+    LoadWaveAsync(wav, JOBPRIORITY_LOAD);
+    CONST BOOL loaded = CHECK(WaitForWaveLoad(wav, TEST_TIMEOUT));
+
+    DeleteFileA(path);
+
+    if (!loaded) {
+        ReleaseWave(wav);
+        return NULL;
+    }
+
+    return wav;
+}
+
+// Renders a hop with the thumb at the target, returns its RMS level in full scale.
+double RenderScrubTestHop(WAVEPTR lpWav, double fTarget) {
+    CONST UINT32 frames = RenderScrub(&TestScrub, lpWav, (UINT64)fTarget, ScrubTestOutput);
+
+    double power = 0.0;
+    for (UINT32 i = 0; i < frames * SCRUB_TEST_CHANNELS; i++) {
+        power += (double)ScrubTestOutput[i] * ScrubTestOutput[i];
+    }
+
+    return frames == 0 ? 0.0 : sqrt(power / (frames * SCRUB_TEST_CHANNELS)) / 32768.0;
+}
+
+// Read head stays within a grain of the thumb at any drag speed, and goes silent once it stops.
+VOID TestScrubFollowsThumb(WAVEPTR lpWav) {
+    CONST UINT32 hop = TestScrub.nHopSize;
+    CONST double speeds[] = { 0.5, 1.0, 2.0, 4.0, 16.0, -1.0, -16.0 };
+
+    for (UINT32 s = 0; s < ARRAYSIZE(speeds); s++) {
+        double target = 0.0 < speeds[s] ? SCRUB_TEST_RATE / 4 : SCRUB_TEST_FRAMES - SCRUB_TEST_RATE / 4;
+        ResetScrub(&TestScrub, (UINT64)target);
+
+        double level = 0.0;
+        for (UINT32 i = 0; i < 40; i++) {
+            target += speeds[s] * hop;
+            level = RenderScrubTestHop(lpWav, target);
+
+            if (!CHECK(fabs(TestScrub.fPosition - target) <= TestScrub.nGrainSize + fabs(speeds[s]) * hop)) { break; }
+        }
+
+        CHECK(0.1 < level);
+
+        for (UINT32 i = 0; i < 40; i++) {
+            level = RenderScrubTestHop(lpWav, target);
+        }
+
+        CHECK(level < 0.001);
+    }
+}
+
+// Thumb that moves in steps of a mouse message, a few hops apart, keeps the sound going.
+VOID TestScrubSteppedThumb(WAVEPTR lpWav) {
+    CONST UINT32 hop = TestScrub.nHopSize;
+
+    double target = SCRUB_TEST_FRAMES / 4;
+    ResetScrub(&TestScrub, (UINT64)target);
+
+    double quietest = 1.0;
+    for (UINT32 i = 0; i < 60; i++) {
+        if (i % 3 == 0) { target += 3.0 * hop; }
+
+        CONST double level = RenderScrubTestHop(lpWav, target);
+        if (6 <= i) { quietest = min(quietest, level); }
+    }
+
+    CHECK(0.05 < quietest);
+}
+
+// Thumb that jumps away brings the read head along on the next hop.
+VOID TestScrubJump(WAVEPTR lpWav) {
+    ResetScrub(&TestScrub, 0);
+
+    RenderScrubTestHop(lpWav, SCRUB_TEST_FRAMES / 2);
+    CHECK(fabs(TestScrub.fPosition - SCRUB_TEST_FRAMES / 2) <= TestScrub.nGrainSize);
+
+    RenderScrubTestHop(lpWav, 1000);
+    CHECK(fabs(TestScrub.fPosition - 1000) <= TestScrub.nGrainSize);
+}
+
+VOID RunScrubTests() {
+    WAVEPTR wav = OpenScrubTestWave();
+    if (wav == NULL) { return; }
+
+    if (CHECK(InitializeScrub(&TestScrub, &wav->wfxFormat))) {
+        TestScrubFollowsThumb(wav);
+        TestScrubSteppedThumb(wav);
+        TestScrubJump(wav);
+    }
+
+    ReleaseWave(wav);
+}
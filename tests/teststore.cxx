@@ -0,0 +1,189 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "store.hxx"
+#include "tests.hxx"
+
+#define STORE_TEST_RATE         44100
+#define STORE_TEST_FRAMES       (STORE_TEST_RATE * 20 + 1234)
+#define STORE_TEST_MAX_CHANNELS 6
+
+SAMPLESTORE TestStore;
+
+BYTE StoreTestSamples[STORE_TEST_FRAMES * STORE_TEST_MAX_CHANNELS * 3];
+BYTE StoreTestOutput[STORE_TEST_FRAMES * STORE_TEST_MAX_CHANNELS * 3];
+
+VOID SetStoreTestFormat(LPWAVEFORMATEX lpFormat, WORD nChannels, WORD wBitsPerSample) {
+    ZeroMemory(lpFormat, sizeof(WAVEFORMATEX));
+
+    lpFormat->wFormatTag = WAVE_FORMAT_PCM;
+    lpFormat->nChannels = nChannels;
+    lpFormat->nSamplesPerSec = STORE_TEST_RATE;
+    lpFormat->wBitsPerSample = wBitsPerSample;
+    lpFormat->nBlockAlign = nChannels * (wBitsPerSample >> 3);
+    lpFormat->nAvgBytesPerSec = STORE_TEST_RATE * lpFormat->nBlockAlign;
+}
+
+// Music-like signal, a few tones with some noise on top, and full scale peaks now and then.
+VOID FillStoreTestSamples(CONST LPWAVEFORMATEX lpFormat) {
+    CONST WORD bytes = lpFormat->wBitsPerSample >> 3;
+    CONST double scale = (double)(1 << (lpFormat->wBitsPerSample - 1));
+
+    UINT32 seed = 7;
+
+    for (UINT32 i = 0; i < STORE_TEST_FRAMES; i++) {
+        for (UINT32 c = 0; c < lpFormat->nChannels; c++) {
+            seed = seed * 1664525 + 1013904223;
+
+            CONST double t = (double)i / STORE_TEST_RATE;
+            double value = 0.3 * sin(2.0 * 3.14159265358979 * 220.0 * t)
+                + 0.2 * sin(2.0 * 3.14159265358979 * (330.0 + 110.0 * c) * t)
+                + ((INT)(seed >> 20) - 2048) / 2048.0 * 0.002;
+
+            if (i % 50000 == 0) { value = c == 0 ? 1.0 : -1.0; }
+
+            CONST INT sample = (INT)max(min(value * scale, scale - 1.0), -scale);
+            BYTE* output = &StoreTestSamples[i * lpFormat->nBlockAlign + c * bytes];
+
+            for (WORD b = 0; b < bytes; b++) {
+                output[b] = (BYTE)(sample >> (8 * b));
+            }
+        }
+    }
+}
+
+BOOL CompressStoreTestSamples(CONST LPWAVEFORMATEX lpFormat) {
+    if (!InitializeSampleStore(&TestStore, lpFormat, STORE_TEST_FRAMES)) { return FALSE; }
+
+    for (DWORD b = 0; b < TestStore.nNumBlocks; b++) {
+        CONST DWORD first = b * TestStore.nFramesPerBlock;
+        CONST DWORD frames = min(TestStore.nFramesPerBlock, STORE_TEST_FRAMES - first);
+
+        if (!CompressSampleBlock(&TestStore, b,
+            &StoreTestSamples[first * lpFormat->nBlockAlign], frames)) {
+            return FALSE;
+        }
+    }
+
+    CompleteSampleStore(&TestStore);
+
+    return TRUE;
+}
+
+VOID TestStoreSupport() {
+    WAVEFORMATEX format;
+
+    SetStoreTestFormat(&format, 2, 8);
+    CHECK(!IsSampleStoreSupported(&format));
+
+    SetStoreTestFormat(&format, 2, 16);
+    CHECK(IsSampleStoreSupported(&format));
+
+    SetStoreTestFormat(&format, 2, 24);
+    CHECK(IsSampleStoreSupported(&format));
+}
+
+// Any range of frames reads back exactly as it was compressed.
+VOID TestStoreRoundTrip(WORD nChannels, WORD wBitsPerSample) {
+    WAVEFORMATEX format;
+    SetStoreTestFormat(&format, nChannels, wBitsPerSample);
+    FillStoreTestSamples(&format);
+
+    if (!CHECK(CompressStoreTestSamples(&format))) {
+        ReleaseSampleStore(&TestStore);
+        return;
+    }
+
+    ReadSampleStore(&TestStore, 0, STORE_TEST_FRAMES, StoreTestOutput);
+    CHECK(memcmp(StoreTestSamples, StoreTestOutput, (size_t)STORE_TEST_FRAMES * format.nBlockAlign) == 0);
+
+    UINT32 seed = 3;
+    for (UINT32 i = 0; i < 64; i++) {
+        seed = seed * 1664525 + 1013904223;
+        CONST DWORD frame = (seed >> 8) % STORE_TEST_FRAMES;
+        CONST DWORD frames = min((seed & 0xFF) * 37 + 1, STORE_TEST_FRAMES - frame);
+
+        ReadSampleStore(&TestStore, frame, frames, StoreTestOutput);
+
+        if (!CHECK(memcmp(&StoreTestSamples[frame * format.nBlockAlign], StoreTestOutput,
+            (size_t)frames * format.nBlockAlign) == 0)) {
+            break;
+        }
+    }
+
+    SAMPLESTOREMETRICS metrics;
+    GetSampleStoreMetrics(&TestStore, &metrics);
+
+    CHECK(metrics.nUncompressedSize == (size_t)STORE_TEST_FRAMES * format.nBlockAlign);
+    CHECK(0 < metrics.nCompressedSize && metrics.nCompressedSize < metrics.nUncompressedSize);
+    CHECK(STORE_TEST_FRAMES <= metrics.nDecodedFrames);
+
+    // Encoder buffers are gone once the store is complete.
+    CHECK(TestStore.lpEncodeChannels == NULL && TestStore.lpEncodeBuffer == NULL);
+    CHECK(!CompressSampleBlock(&TestStore, 0, StoreTestSamples, 1));
+
+    ReleaseSampleStore(&TestStore);
+}
+
+// Compression ratio, and the cost of decoding the whole signal block by block, as the playback does.
+VOID BenchmarkStore(WORD nChannels, WORD wBitsPerSample) {
+    WAVEFORMATEX format;
+    SetStoreTestFormat(&format, nChannels, wBitsPerSample);
+    FillStoreTestSamples(&format);
+
+    CONST double start = GetTestTime();
+    CONST BOOL compressed = CompressStoreTestSamples(&format);
+    CONST double encode = GetTestTime() - start;
+
+    if (compressed) {
+        for (DWORD i = 0; i < STORE_TEST_FRAMES; i += STORE_TEST_RATE / 100) {
+            ReadSampleStore(&TestStore, i, min(STORE_TEST_RATE / 100, STORE_TEST_FRAMES - i), StoreTestOutput);
+        }
+
+        SAMPLESTOREMETRICS metrics;
+        GetSampleStoreMetrics(&TestStore, &metrics);
+
+        CONST double seconds = (double)STORE_TEST_FRAMES / STORE_TEST_RATE;
+
+        printf("Store %u-bit, %u channel(s): %.1f%% of the size, encoding %.3f%% and decoding %.3f%% of a core.\n",
+            wBitsPerSample, nChannels, 100.0 * metrics.nCompressedSize / metrics.nUncompressedSize,
+            100.0 * encode / seconds, 100.0 * metrics.nDecodeTime / 1000000.0 / seconds);
+    }
+
+    ReleaseSampleStore(&TestStore);
+}
+
+VOID RunStoreTests() {
+    TestStoreSupport();
+    TestStoreRoundTrip(1, 16);
+    TestStoreRoundTrip(2, 16);
+    TestStoreRoundTrip(2, 24);
+    TestStoreRoundTrip(6, 24);
+
+    if (IsBenchmarkRequested()) {
+        BenchmarkStore(2, 16);
+        BenchmarkStore(2, 24);
+    }
+}
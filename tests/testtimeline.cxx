@@ -0,0 +1,190 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "tests.hxx"
+#include "timeline.hxx"
+
+#define TIMELINE_TEST_RATE          48000
+#define TIMELINE_TEST_FREQUENCY     HUNDRED_NANOSECONDS_PER_SECOND   // Of the device position.
+#define TIMELINE_TEST_READS         10000000
+
+// Frames of consecutive publications differ in both halves, so that a torn read does not match.
+#define TIMELINE_TEST_STRIDE        0x100000001ULL
+
+TIMELINE TestTimeline;
+volatile LONG TimelineTestDone;
+
+VOID TestTimelineStopped() {
+    TIMELINE tl;
+    ZeroMemory(&tl, sizeof(TIMELINE));
+
+    PublishTimeline(&tl, 1000, 5000, HUNDRED_NANOSECONDS_PER_SECOND);
+
+    // The position does not move while paused or idle, whatever the clock says.
+    CHECK(GetTimelineFrame(&tl, HUNDRED_NANOSECONDS_PER_SECOND, TIMELINE_TEST_RATE, FALSE) == 1000);
+    CHECK(GetTimelineFrame(&tl, 60 * HUNDRED_NANOSECONDS_PER_SECOND, TIMELINE_TEST_RATE, FALSE) == 1000);
+}
+
+VOID TestTimelineExtrapolation() {
+    TIMELINE tl;
+    ZeroMemory(&tl, sizeof(TIMELINE));
+
+    CONST UINT64 time = 10 * HUNDRED_NANOSECONDS_PER_SECOND;
+
+    PublishTimeline(&tl, 1000, 1000 + TIMELINE_TEST_RATE, time);
+
+    CHECK(GetTimelineFrame(&tl, time, TIMELINE_TEST_RATE, TRUE) == 1000);
+
+    // A clock reading older than the publication does not rewind the position.
+    CHECK(GetTimelineFrame(&tl, time - HUNDRED_NANOSECONDS_PER_SECOND, TIMELINE_TEST_RATE, TRUE) == 1000);
+
+    // Half a millisecond is 24 frames, 100ns is less than a frame.
+    CHECK(GetTimelineFrame(&tl, time + 5000, TIMELINE_TEST_RATE, TRUE) == 1024);
+    CHECK(GetTimelineFrame(&tl, time + 1, TIMELINE_TEST_RATE, TRUE) == 1000);
+
+    CHECK(GetTimelineFrame(&tl, time + HUNDRED_NANOSECONDS_PER_SECOND / 2, TIMELINE_TEST_RATE, TRUE)
+        == 1000 + TIMELINE_TEST_RATE / 2);
+
+    // Extrapolation stops at the frames that were written.
+    CHECK(GetTimelineFrame(&tl, time + HUNDRED_NANOSECONDS_PER_SECOND, TIMELINE_TEST_RATE, TRUE)
+        == 1000 + TIMELINE_TEST_RATE);
+    CHECK(GetTimelineFrame(&tl, time + 5 * HUNDRED_NANOSECONDS_PER_SECOND, TIMELINE_TEST_RATE, TRUE)
+        == 1000 + TIMELINE_TEST_RATE);
+
+    // Seeking back publishes an earlier frame along with its write cursor.
+    PublishTimeline(&tl, 0, 0, time + HUNDRED_NANOSECONDS_PER_SECOND);
+
+    CHECK(GetTimelineFrame(&tl, time + 2 * HUNDRED_NANOSECONDS_PER_SECOND, TIMELINE_TEST_RATE, TRUE) == 0);
+}
+
+// Device position in units of the test frequency, a number of frames into the stream.
+UINT64 GetTimelineTestPosition(UINT64 nFrames) {
+    return nFrames * TIMELINE_TEST_FREQUENCY / TIMELINE_TEST_RATE;
+}
+
+// Frames submitted past the device position are still queued, and not heard yet.
+VOID TestTimelineQueuedFrames() {
+    CONST UINT64 rate = TIMELINE_TEST_RATE;
+
+    CHECK(GetAudibleFrame(0, TIMELINE_TEST_FREQUENCY, TIMELINE_TEST_RATE, rate, 0, rate) == 0);
+    CHECK(GetAudibleFrame(GetTimelineTestPosition(rate / 2),
+        TIMELINE_TEST_FREQUENCY, TIMELINE_TEST_RATE, rate, 0, rate) == rate / 2);
+
+    // Playback started from a later frame.
+    CHECK(GetAudibleFrame(GetTimelineTestPosition(rate / 4),
+        TIMELINE_TEST_FREQUENCY, TIMELINE_TEST_RATE, rate, 1000, 1000 + rate) == 1000 + rate / 4);
+
+    // A position past the submitted frames, as after a glitch, stops at the write cursor.
+    CHECK(GetAudibleFrame(GetTimelineTestPosition(2 * rate),
+        TIMELINE_TEST_FREQUENCY, TIMELINE_TEST_RATE, rate, 0, rate) == rate);
+
+    // Ten hours at 192 kHz, the position in frames would overflow on the way.
+    CONST UINT64 frames = 10 * 60 * 60 * 192000ULL;
+    CHECK(GetAudibleFrame(10 * 60 * 60 * (UINT64)TIMELINE_TEST_FREQUENCY,
+        TIMELINE_TEST_FREQUENCY, 192000, frames + 1000, 0, frames + 1000) == frames);
+}
+
+// Frames queued before a seek do not move the position back past the frame seeked to.
+VOID TestTimelineSeekDuringPlayback() {
+    CONST UINT64 rate = TIMELINE_TEST_RATE;
+
+    // Half of the second submitted before the seek is still queued.
+    UINT64 submitted = rate;
+    CONST UINT64 seek = 5 * rate;
+
+    CHECK(GetAudibleFrame(GetTimelineTestPosition(rate / 2),
+        TIMELINE_TEST_FREQUENCY, TIMELINE_TEST_RATE, submitted, seek, seek) == seek);
+
+    // Frames written after the seek queue up behind the old ones.
+    submitted += 10000;
+
+    CHECK(GetAudibleFrame(GetTimelineTestPosition(rate / 2),
+        TIMELINE_TEST_FREQUENCY, TIMELINE_TEST_RATE, submitted, seek, seek + 10000) == seek);
+    CHECK(GetAudibleFrame(GetTimelineTestPosition(rate),
+        TIMELINE_TEST_FREQUENCY, TIMELINE_TEST_RATE, submitted, seek, seek + 10000) == seek);
+    CHECK(GetAudibleFrame(GetTimelineTestPosition(rate + 4800),
+        TIMELINE_TEST_FREQUENCY, TIMELINE_TEST_RATE, submitted, seek, seek + 10000) == seek + 4800);
+}
+
+// Scrubbing restarts the stream, grains still queued when the thumb is released do not count
+// as frames of the playback that continues from there.
+VOID TestTimelineAfterScrub() {
+    CONST UINT64 hop = TIMELINE_TEST_RATE / 100;
+    CONST UINT64 release = 200000;
+
+    // Four grains were submitted, one of them was heard.
+    UINT64 submitted = 4 * hop;
+
+    CHECK(GetAudibleFrame(GetTimelineTestPosition(hop),
+        TIMELINE_TEST_FREQUENCY, TIMELINE_TEST_RATE, submitted, release, release) == release);
+
+    submitted += 4800;
+
+    CHECK(GetAudibleFrame(GetTimelineTestPosition(4 * hop),
+        TIMELINE_TEST_FREQUENCY, TIMELINE_TEST_RATE, submitted, release, release + 4800) == release);
+    CHECK(GetAudibleFrame(GetTimelineTestPosition(4 * hop + 2400),
+        TIMELINE_TEST_FREQUENCY, TIMELINE_TEST_RATE, submitted, release, release + 4800) == release + 2400);
+}
+
+DWORD WINAPI TimelineTestWriterMain(LPVOID lpThreadParameter) {
+    for (UINT64 i = 1; !TimelineTestDone; i++) {
+        PublishTimeline(&TestTimeline, i * TIMELINE_TEST_STRIDE, i * TIMELINE_TEST_STRIDE + 1, 0);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+VOID TestTimelineConcurrency() {
+    ZeroMemory(&TestTimeline, sizeof(TIMELINE));
+    TimelineTestDone = FALSE;
+
+    HANDLE thread = CreateThread(NULL, 0, TimelineTestWriterMain, NULL, 0, NULL);
+    if (!CHECK(thread != NULL)) { return; }
+
+    // A second at two frames per second runs a frame past the write cursor, so a consistent
+    // read always lands on the cursor. A frame mixed with the cursor of a later publication
+    // lands a frame past its own cursor, and a torn 64-bit frame or cursor is off the stride.
+    UINT32 failures = 0;
+    for (UINT32 i = 0; i < TIMELINE_TEST_READS; i++) {
+        CONST UINT64 frame = GetTimelineFrame(&TestTimeline, HUNDRED_NANOSECONDS_PER_SECOND, 2, TRUE);
+
+        if (frame != 0 && (frame - 1) % TIMELINE_TEST_STRIDE != 0) { failures++; }
+    }
+
+    InterlockedExchange(&TimelineTestDone, TRUE);
+
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+
+    CHECK(failures == 0);
+    CHECK(GetTimelineFrame(&TestTimeline, 0, 2, FALSE) % TIMELINE_TEST_STRIDE == 0);
+    CHECK((TestTimeline.nSequence & 1) == 0);
+}
+
+VOID RunTimelineTests() {
+    TestTimelineStopped();
+    TestTimelineExtrapolation();
+    TestTimelineQueuedFrames();
+    TestTimelineSeekDuringPlayback();
+    TestTimelineAfterScrub();
+    TestTimelineConcurrency();
+}
@@ -0,0 +1,217 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include "tests.hxx"
+#include "wave.hxx"
+
+#define WAVE_TEST_RATE          44100
+#define WAVE_TEST_CHANNELS      2
+#define WAVE_TEST_FRAMES        (WAVE_TEST_RATE * 30)
+
+#define WAVE_BENCHMARK_MB       (1024 * 1024)
+#define WAVE_BENCHMARK_HEADER   (4 + 8 + sizeof(PCMWAVEFORMAT) + 8)    // RIFF size past the data.
+#define WAVE_BENCHMARK_TIMEOUT  (10 * 60 * 1000)                        // In Milliseconds
+
+SHORT WaveTestSamples[WAVE_TEST_FRAMES * WAVE_TEST_CHANNELS];
+SHORT WaveTestOutput[WAVE_TEST_FRAMES * WAVE_TEST_CHANNELS];
+
+VOID SetWaveTestFormat(LPWAVEFORMATEX lpFormat) {
+    ZeroMemory(lpFormat, sizeof(WAVEFORMATEX));
+
+    lpFormat->wFormatTag = WAVE_FORMAT_PCM;
+    lpFormat->nChannels = WAVE_TEST_CHANNELS;
+    lpFormat->nSamplesPerSec = WAVE_TEST_RATE;
+    lpFormat->wBitsPerSample = 16;
+    lpFormat->nBlockAlign = WAVE_TEST_CHANNELS * sizeof(SHORT);
+    lpFormat->nAvgBytesPerSec = WAVE_TEST_RATE * lpFormat->nBlockAlign;
+}
+
+// Music-like signal, a tone with some noise on top.
+VOID FillWaveTestSamples() {
+    UINT32 seed = 1;
+
+    for (UINT32 i = 0; i < WAVE_TEST_FRAMES; i++) {
+        for (UINT32 c = 0; c < WAVE_TEST_CHANNELS; c++) {
+            seed = seed * 1664525 + 1013904223;
+
+            CONST double tone = sin(2.0 * 3.14159265358979 * 220.0 * (c + 1) * i / WAVE_TEST_RATE) * 8000.0;
+            WaveTestSamples[i * WAVE_TEST_CHANNELS + c] = (SHORT)(tone + (INT)(seed >> 24) - 128);
+        }
+    }
+}
+
+// Whole wave loads in the background and reads back as written.
+VOID TestWaveLoad(LPCSTR lpszPath) {
+    WAVEPTR wav = OpenWave(lpszPath, 0);
+    if (!CHECK(wav != NULL)) { return; }
+
+    CHECK(wav->dwNumFrames == WAVE_TEST_FRAMES);
+    CHECK(0 < GetWaveLoadedFrames(wav));
+
+    CHECK(LoadWaveAsync(wav, JOBPRIORITY_LOAD));
+
+    if (CHECK(WaitForWaveLoad(wav, TEST_TIMEOUT))) {
+        ReadWaveFrames(wav, 0, WAVE_TEST_FRAMES, WaveTestOutput);
+        CHECK(memcmp(WaveTestSamples, WaveTestOutput, sizeof(WaveTestSamples)) == 0);
+    }
+
+    ReleaseWave(wav);
+}
+
+// Waves released while their job is still loading them are freed by that job.
+VOID TestWaveReleaseWhileLoading(LPCSTR lpszPath) {
+    for (UINT32 i = 0; i < 32; i++) {
+        WAVEPTR wav = OpenWave(lpszPath, 0);
+        if (!CHECK(wav != NULL)) { return; }
+
+        CHECK(LoadWaveAsync(wav, (JOBPRIORITY)(i % JOBPRIORITY_COUNT)));
+
+        // Some are released once loaded, with the job done, the rest while it is queued or running.
+        if (i % 4 == 0) { CHECK(WaitForWaveLoad(wav, TEST_TIMEOUT)); }
+
+        ReleaseWave(wav);
+    }
+}
+
+// PCM frames follow from the data size, whatever the fact chunk says, and a partial
+// frame at the end of the data is dropped, with or without compression in memory.
+VOID TestWaveFactChunk() {
+    WAVEFORMATEX format;
+    SetWaveTestFormat(&format);
+
+    CHAR path[MAX_PATH];
+    GetTestWavePath(path, "fact");
+
+    CONST DWORD flags[] = { 0, WAVE_FLAG_COMPRESS };
+
+    for (UINT32 f = 0; f < ARRAYSIZE(flags); f++) {
+        if (!CHECK(WriteTestWave(path, &format, WaveTestSamples, sizeof(WaveTestSamples) - 1, WAVE_TEST_FRAMES / 3))) { return; }
+
+        WAVEPTR wav = OpenWave(path, flags[f]);
+        if (!CHECK(wav != NULL)) { break; }
+
+        CHECK(wav->dwNumFrames == WAVE_TEST_FRAMES - 1);
+
+        LoadWaveAsync(wav, JOBPRIORITY_LOAD);
+
+        if (CHECK(WaitForWaveLoad(wav, TEST_TIMEOUT))) {
+            CHECK(wav->dwNumFrames == WAVE_TEST_FRAMES - 1);
+
+            ReadWaveFrames(wav, 0, wav->dwNumFrames, WaveTestOutput);
+            CHECK(memcmp(WaveTestSamples, WaveTestOutput, (size_t)wav->dwNumFrames * format.nBlockAlign) == 0);
+        }
+
+        ReleaseWave(wav);
+    }
+
+    DeleteFileA(path);
+}
+
+// Without job workers, the wave is loaded by a thread of its own, not by the caller.
+VOID TestWaveLoaderThread(LPCSTR lpszPath) {
+    ReleaseJobs();
+
+    TestWaveLoad(lpszPath);
+    TestWaveReleaseWhileLoading(lpszPath);
+
+    // Loader threads of the released waves free them, and close the file, before it goes away.
+    CHECK(WaitForWaveLoaders(TEST_TIMEOUT));
+
+    InitializeJobs(TEST_JOB_WORKERS, 0);
+}
+
+// Time the caller of OpenWave is blocked for, the time until the first frame can be read,
+// and the time until the whole file is loaded. The file was just written, so it is read from
+// the file system cache when it fits. RIFF sizes are 32-bit, files of 4GB and more need RF64,
+// which is not supported.
+VOID BenchmarkWaveOpen(DWORD dwSize) {
+    WAVEFORMATEX format;
+    SetWaveTestFormat(&format);
+
+    CHAR path[MAX_PATH];
+    GetTestWavePath(path, "benchmark");
+
+    if (!CHECK(WriteLongTestWave(path, &format, WaveTestSamples, sizeof(WaveTestSamples), dwSize, 0))) { return; }
+
+    CONST double start = GetTestTime();
+    WAVEPTR wav = OpenWave(path, 0);
+    CONST double blocking = GetTestTime() - start;
+
+    if (CHECK(wav != NULL)) {
+        while (GetWaveLoadedFrames(wav) == 0 && GetTestTime() - start < TEST_TIMEOUT / 1000.0) {
+            YieldProcessor();
+        }
+
+        CONST BOOL readable = CHECK(0 < GetWaveLoadedFrames(wav));
+
+        SHORT frame[WAVE_TEST_CHANNELS];
+        if (readable) { ReadWaveFrames(wav, 0, 1, frame); }
+
+        CONST double first = GetTestTime() - start;
+
+        CHECK(LoadWaveAsync(wav, JOBPRIORITY_LOAD));
+
+        if (CHECK(WaitForWaveLoad(wav, WAVE_BENCHMARK_TIMEOUT)) && readable) {
+            WAVEMETRICS metrics;
+            GetWaveMetrics(wav, &metrics);
+
+            printf("Wave %u MB: open blocked for %.2f ms, first frame after %.2f ms, loaded in %.1f ms.\n",
+                dwSize / WAVE_BENCHMARK_MB, blocking * 1000.0, first * 1000.0, metrics.dwLoadTime / 1000.0);
+        }
+
+        ReleaseWave(wav);
+    }
+
+    DeleteFileA(path);
+}
+
+VOID RunWaveTests() {
+    FillWaveTestSamples();
+
+    WAVEFORMATEX format;
+    SetWaveTestFormat(&format);
+
+    CHAR path[MAX_PATH];
+    GetTestWavePath(path, "wave");
+
+    if (!CHECK(WriteTestWave(path, &format, WaveTestSamples, sizeof(WaveTestSamples), 0))) { return; }
+
+    TestWaveLoad(path);
+    TestWaveReleaseWhileLoading(path);
+    TestWaveLoaderThread(path);
+    TestWaveFactChunk();
+
+    DeleteFileA(path);
+
+    if (IsBenchmarkRequested()) {
+        BenchmarkWaveOpen(10 * WAVE_BENCHMARK_MB);
+        BenchmarkWaveOpen(100 * WAVE_BENCHMARK_MB);
+        BenchmarkWaveOpen(1024 * WAVE_BENCHMARK_MB);
+
+        // Largest whole number of frames a RIFF header can describe.
+        BenchmarkWaveOpen((MAXDWORD - WAVE_BENCHMARK_HEADER) / (WAVE_TEST_CHANNELS * sizeof(SHORT))
+            * (WAVE_TEST_CHANNELS * sizeof(SHORT)));
+    }
+}
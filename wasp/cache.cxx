@@ -0,0 +1,309 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "cache.hxx"
+#include "mem.hxx"
+
+#define WAVE_FILE_PATTERN   "*.wav"
+
+BOOL GetWaveFileKey(LPCSTR lpszPath, ULONGLONG* lpSize, FILETIME* lpTime) {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(lpszPath, GetFileExInfoStandard, &data)) { return FALSE; }
+
+    *lpSize = ((ULONGLONG)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    *lpTime = data.ftLastWriteTime;
+
+    return TRUE;
+}
+
+size_t GetWaveCacheSize(WAVECACHEPTR lpCache) {
+    // Sizes of compressed waves shrink once they are loaded, so sum them up every time.
+    size_t size = 0;
+    for (UINT32 i = 0; i < lpCache->nCount; i++) {
+        size += GetWaveMemorySize(lpCache->lpEntries[i].lpWave);
+    }
+
+    return size;
+}
+
+// Returns the wave removed from the cache, for the caller to release outside of the lock.
+WAVEPTR DetachWaveCacheEntry(WAVECACHEPTR lpCache, UINT32 nIndex) {
+    WAVEPTR wav = lpCache->lpEntries[nIndex].lpWave;
+
+    // Order of entries does not matter, move the last one into the gap.
+    lpCache->nCount--;
+    lpCache->lpEntries[nIndex] = lpCache->lpEntries[lpCache->nCount];
+
+    return wav;
+}
+
+WAVEPTR EvictWaveCacheEntry(WAVECACHEPTR lpCache) {
+    UINT32 index = lpCache->nCount;
+
+    for (UINT32 i = 0; i < lpCache->nCount; i++) {
+        WAVECACHEENTRYPTR entry = &lpCache->lpEntries[i];
+
+        // Skip waves that are still referenced outside of the cache, i.e. playing.
+        if (entry->lpWave->nRefCount != 1) { continue; }
+
+        if (index == lpCache->nCount
+            || entry->ullLastUse < lpCache->lpEntries[index].ullLastUse) {
+            index = i;
+        }
+    }
+
+    if (index == lpCache->nCount) { return NULL; }
+
+    return DetachWaveCacheEntry(lpCache, index);
+}
+
+WAVEPTR FindCachedWave(WAVECACHEPTR lpCache,
+    LPCSTR lpszPath, ULONGLONG ullSize, CONST FILETIME* lpTime, WAVEPTR* lpStale) {
+    for (UINT32 i = 0; i < lpCache->nCount; i++) {
+        WAVECACHEENTRYPTR entry = &lpCache->lpEntries[i];
+
+        if (lstrcmpiA(entry->lpWave->szPath, lpszPath) != 0) { continue; }
+
+        if (entry->ullFileSize == ullSize && CompareFileTime(&entry->ftLastWrite, lpTime) == 0) {
+            entry->ullLastUse = ++lpCache->ullTick;
+            return AcquireWave(entry->lpWave);
+        }
+
+        // The file was modified since it was cached, drop the stale copy.
+        *lpStale = DetachWaveCacheEntry(lpCache, i);
+        break;
+    }
+
+    return NULL;
+}
+
+WAVEPTR InsertCachedWave(WAVECACHEPTR lpCache, WAVEPTR lpWav, ULONGLONG ullSize, CONST FILETIME* lpTime) {
+    WAVEPTR released[MAX_WAVE_CACHE_CAPACITY + 1];
+    UINT32 count = 0;
+
+    EnterCriticalSection(&lpCache->csLock);
+
+    // Another thread may have cached the same file while this one was opening it.
+    WAVEPTR stale = NULL;
+    WAVEPTR cached = FindCachedWave(lpCache, lpWav->szPath, ullSize, lpTime, &stale);
+
+    if (cached != NULL) {
+        released[count++] = lpWav;
+        lpWav = cached;
+    }
+    else {
+        if (stale != NULL) { released[count++] = stale; }
+
+        // Waves that do not fit the budget are handed out without being cached.
+        CONST size_t bytes = GetWaveMemorySize(lpWav);
+
+        if (bytes <= lpCache->nBudget) {
+            while (lpCache->nCount == lpCache->nCapacity
+                || lpCache->nBudget < GetWaveCacheSize(lpCache) + bytes) {
+                WAVEPTR evicted = EvictWaveCacheEntry(lpCache);
+
+                if (evicted == NULL) { break; }
+
+                released[count++] = evicted;
+            }
+
+            if (lpCache->nCount < lpCache->nCapacity
+                && GetWaveCacheSize(lpCache) + bytes <= lpCache->nBudget) {
+                WAVECACHEENTRYPTR entry = &lpCache->lpEntries[lpCache->nCount];
+
+                entry->lpWave = AcquireWave(lpWav);
+                entry->ullFileSize = ullSize;
+                entry->ftLastWrite = *lpTime;
+                entry->ullLastUse = ++lpCache->ullTick;
+
+                lpCache->nCount++;
+            }
+        }
+    }
+
+    LeaveCriticalSection(&lpCache->csLock);
+
+    // Releasing a wave may wait for its loading job, never do that under the lock.
+    for (UINT32 i = 0; i < count; i++) {
+        ReleaseWave(released[i]);
+    }
+
+    return lpWav;
+}
+
+WAVECACHEPTR InitializeWaveCache(size_t nBudget, UINT32 nCapacity, DWORD dwWaveFlags, BOOL bWarmUp) {
+    if (nCapacity == 0 || MAX_WAVE_CACHE_CAPACITY < nCapacity) { return NULL; }
+
+    WAVECACHEPTR cache = (WAVECACHEPTR)AllocateMemory(sizeof(WAVECACHE));
+
+    if (cache == NULL) { return NULL; }
+
+    ZeroMemory(cache, sizeof(WAVECACHE));
+
+    cache->lpEntries = (WAVECACHEENTRYPTR)AllocateMemory(nCapacity * sizeof(WAVECACHEENTRY));
+
+    if (cache->lpEntries == NULL) {
+        FreeMemory(cache);
+        return NULL;
+    }
+
+    InitializeCriticalSection(&cache->csLock);
+
+    cache->nCapacity = nCapacity;
+    cache->nBudget = nBudget;
+    cache->dwWaveFlags = dwWaveFlags;
+    cache->bWarmUp = bWarmUp;
+
+    return cache;
+}
+
+VOID ReleaseWaveCache(WAVECACHEPTR lpCache) {
+    if (lpCache == NULL) { return; }
+
+    while (lpCache->nCount != 0) {
+        ReleaseWave(DetachWaveCacheEntry(lpCache, lpCache->nCount - 1));
+    }
+
+    DeleteCriticalSection(&lpCache->csLock);
+
+    FreeMemory(lpCache->lpEntries);
+    FreeMemory(lpCache);
+}
+
+WAVEPTR OpenCachedWave(WAVECACHEPTR lpCache, LPCSTR lpszPath, JOBPRIORITY dwPriority) {
+    if (lpszPath == NULL) { return NULL; }
+
+    if (lpCache == NULL) {
+        WAVEPTR wav = OpenWave(lpszPath, 0);
+        LoadWaveAsync(wav, dwPriority);
+
+        return wav;
+    }
+
+    ULONGLONG size = 0;
+    FILETIME time;
+    if (!GetWaveFileKey(lpszPath, &size, &time)) { return NULL; }
+
+    WAVEPTR stale = NULL;
+
+    EnterCriticalSection(&lpCache->csLock);
+    WAVEPTR wav = FindCachedWave(lpCache, lpszPath, size, &time, &stale);
+    LeaveCriticalSection(&lpCache->csLock);
+
+    ReleaseWave(stale);
+
+    if (wav == NULL) {
+        wav = OpenWave(lpszPath, lpCache->dwWaveFlags);
+
+        if (wav == NULL) { return NULL; }
+
+        wav = InsertCachedWave(lpCache, wav, size, &time);
+    }
+
+    // Resumes loading of the cached wave, in case it was cancelled, at the requested priority.
+    LoadWaveAsync(wav, dwPriority);
+
+    return wav;
+}
+
+BOOL WarmUpJob(LPVOID lpParameter, JOBPTR lpJob) {
+    WAVECACHEWARMUPPTR warm = (WAVECACHEWARMUPPTR)lpParameter;
+    LPCSTR file = warm->szPath;
+
+    // Split the path into the folder, including the trailing separator, and the file name.
+    LPCSTR name = file;
+    for (LPCSTR c = file; *c != '\0'; c++) {
+        if (*c == '\\' || *c == '/') { name = c + 1; }
+    }
+
+    CONST size_t folder = (size_t)(name - file);
+
+    CHAR path[MAX_PATH];
+    HANDLE find = INVALID_HANDLE_VALUE;
+    WIN32_FIND_DATAA data;
+
+    if (!IsJobCancelled(lpJob) && folder + strlen(WAVE_FILE_PATTERN) < MAX_PATH) {
+        CopyMemory(path, file, folder);
+        strcpy(&path[folder], WAVE_FILE_PATTERN);
+
+        find = FindFirstFileA(path, &data);
+    }
+
+    if (find == INVALID_HANDLE_VALUE) {
+        FreeMemory(warm);
+        return FALSE;
+    }
+
+    // Find the files right before and right after the current one in alphabetical order.
+    CHAR prev[MAX_PATH] = "";
+    CHAR next[MAX_PATH] = "";
+
+    do {
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) { continue; }
+
+        CONST int order = lstrcmpiA(data.cFileName, name);
+
+        if (order < 0 && (*prev == '\0' || lstrcmpiA(data.cFileName, prev) > 0)) {
+            strcpy(prev, data.cFileName);
+        }
+        else if (order > 0 && (*next == '\0' || lstrcmpiA(data.cFileName, next) < 0)) {
+            strcpy(next, data.cFileName);
+        }
+    } while (FindNextFileA(find, &data));
+
+    FindClose(find);
+
+    // The rest of the neighbours is loaded by prefetch jobs while they sit in the cache.
+    LPCSTR neighbours[] = { next, prev };
+
+    for (UINT32 i = 0; i < ARRAYSIZE(neighbours); i++) {
+        if (IsJobCancelled(lpJob)) { break; }
+
+        if (*neighbours[i] == '\0') { continue; }
+        if (folder + strlen(neighbours[i]) >= MAX_PATH) { continue; }
+
+        strcpy(&path[folder], neighbours[i]);
+
+        ReleaseWave(OpenCachedWave(warm->lpCache, path, JOBPRIORITY_PREFETCH));
+    }
+
+    FreeMemory(warm);
+
+    return FALSE;
+}
+
+VOID WarmUpWaveCache(WAVECACHEPTR lpCache, LPCSTR lpszPath) {
+    if (lpCache == NULL || lpszPath == NULL) { return; }
+    if (!lpCache->bWarmUp) { return; }
+
+    WAVECACHEWARMUPPTR warm = (WAVECACHEWARMUPPTR)AllocateMemory(sizeof(WAVECACHEWARMUP));
+
+    if (warm == NULL) { return; }
+
+    warm->lpCache = lpCache;
+    strcpy(warm->szPath, lpszPath);
+
+    // Warm-up is optional, skip it when there are no workers to do that.
+    if (!SubmitJob(WarmUpJob, warm, JOBPRIORITY_PREFETCH)) {
+        FreeMemory(warm);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "wave.hxx"
+
+#define MAX_WAVE_CACHE_CAPACITY 64
+
+typedef struct WaveCacheEntry {
+    WAVEPTR                 lpWave;
+    ULONGLONG               ullFileSize;
+    FILETIME                ftLastWrite;
+    ULONGLONG               ullLastUse;         // Larger values were used more recently.
+} WAVECACHEENTRY, * WAVECACHEENTRYPTR;
+
+typedef struct WaveCache {
+    CRITICAL_SECTION        csLock;             // Cache is shared with the warm-up jobs.
+    WAVECACHEENTRYPTR       lpEntries;
+    UINT32                  nCapacity;          // In Entries
+    UINT32                  nCount;
+
+    size_t                  nBudget;            // In Bytes
+
+    ULONGLONG               ullTick;
+    DWORD                   dwWaveFlags;        // Flags the waves are opened with.
+    BOOL                    bWarmUp;            // Open neighbouring files of the same folder in advance.
+} WAVECACHE, * WAVECACHEPTR;
+
+typedef struct WaveCacheWarmUp {
+    WAVECACHEPTR            lpCache;
+    CHAR                    szPath[MAX_PATH];
+} WAVECACHEWARMUP, * WAVECACHEWARMUPPTR;
+
+WAVECACHEPTR InitializeWaveCache(size_t nBudget, UINT32 nCapacity, DWORD dwWaveFlags, BOOL bWarmUp);
+VOID ReleaseWaveCache(WAVECACHEPTR lpCache);
+
+WAVEPTR OpenCachedWave(WAVECACHEPTR lpCache, LPCSTR lpszPath, JOBPRIORITY dwPriority);
+VOID WarmUpWaveCache(WAVECACHEPTR lpCache, LPCSTR lpszPath);
\ No newline at end of file
@@ -0,0 +1,499 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <emmintrin.h>
+
+#include "codec.hxx"
+#include "mem.hxx"
+
+#include <ks.h>
+#include <ksmedia.h>
+
+#define MAX_CODEC_CHANNELS  8
+
+#define IMA_ADPCM_MAX_INDEX 88
+#define MS_ADPCM_MIN_DELTA  16
+
+static CONST SHORT ImaStepTable[IMA_ADPCM_MAX_INDEX + 1] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static CONST INT ImaIndexTable[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static CONST INT MsAdaptationTable[16] = {
+    230, 230, 230, 230, 307, 409, 512, 614, 768, 614, 512, 409, 307, 230, 230, 230
+};
+
+// G.711 expansion is a single lookup per sample.
+static SHORT MuLawTable[256];
+static SHORT ALawTable[256];
+
+SHORT ExpandMuLaw(BYTE bValue) {
+    CONST INT value = ~bValue & 0xFF;
+    CONST INT magnitude = ((((value & 0x0F) << 3) + 0x84) << ((value & 0x70) >> 4)) - 0x84;
+
+    return (SHORT)((value & 0x80) ? -magnitude : magnitude);
+}
+
+SHORT ExpandALaw(BYTE bValue) {
+    CONST INT value = bValue ^ 0x55;
+    CONST INT segment = (value & 0x70) >> 4;
+
+    INT magnitude = (value & 0x0F) << 4;
+
+    if (segment == 0) { magnitude += 8; }
+    else { magnitude = (magnitude + 0x108) << (segment - 1); }
+
+    return (SHORT)((value & 0x80) ? magnitude : -magnitude);
+}
+
+VOID InitializeCodecs() {
+    for (UINT32 i = 0; i < 256; i++) {
+        MuLawTable[i] = ExpandMuLaw((BYTE)i);
+        ALawTable[i] = ExpandALaw((BYTE)i);
+    }
+}
+
+// Shifts each lane left by its own count, of up to 7 bits, one bit of the count at a time.
+static inline __m128i ShiftG711(__m128i xValue, __m128i xCount) {
+    CONST __m128i one = _mm_set1_epi16(1), two = _mm_set1_epi16(2), four = _mm_set1_epi16(4);
+
+    CONST __m128i by1 = _mm_cmpeq_epi16(_mm_and_si128(xCount, one), one);
+    xValue = _mm_or_si128(_mm_and_si128(by1, _mm_slli_epi16(xValue, 1)), _mm_andnot_si128(by1, xValue));
+
+    CONST __m128i by2 = _mm_cmpeq_epi16(_mm_and_si128(xCount, two), two);
+    xValue = _mm_or_si128(_mm_and_si128(by2, _mm_slli_epi16(xValue, 2)), _mm_andnot_si128(by2, xValue));
+
+    CONST __m128i by4 = _mm_cmpeq_epi16(_mm_and_si128(xCount, four), four);
+    return _mm_or_si128(_mm_and_si128(by4, _mm_slli_epi16(xValue, 4)), _mm_andnot_si128(by4, xValue));
+}
+
+// Same as ExpandMuLaw, for eight samples zero extended into 16-bit lanes.
+static inline __m128i ExpandMuLawLanes(__m128i xValue) {
+    xValue = _mm_xor_si128(xValue, _mm_set1_epi16(0xFF));
+
+    CONST __m128i bias = _mm_set1_epi16(0x84);
+    CONST __m128i mantissa = _mm_slli_epi16(_mm_and_si128(xValue, _mm_set1_epi16(0x0F)), 3);
+    CONST __m128i exponent = _mm_srli_epi16(_mm_and_si128(xValue, _mm_set1_epi16(0x70)), 4);
+    CONST __m128i magnitude = _mm_sub_epi16(ShiftG711(_mm_add_epi16(mantissa, bias), exponent), bias);
+
+    // Negative samples have the sign bit set, x ^ -1 - -1 negates the lane.
+    CONST __m128i sign = _mm_set1_epi16(0x80);
+    CONST __m128i negative = _mm_cmpeq_epi16(_mm_and_si128(xValue, sign), sign);
+
+    return _mm_sub_epi16(_mm_xor_si128(magnitude, negative), negative);
+}
+
+// Same as ExpandALaw, for eight samples zero extended into 16-bit lanes.
+static inline __m128i ExpandALawLanes(__m128i xValue) {
+    xValue = _mm_xor_si128(xValue, _mm_set1_epi16(0x55));
+
+    // First segment has no implicit leading bit and is not shifted,
+    // the others have it and are shifted by one less than their number.
+    CONST __m128i segment = _mm_srli_epi16(_mm_and_si128(xValue, _mm_set1_epi16(0x70)), 4);
+    CONST __m128i leading = _mm_andnot_si128(_mm_cmpeq_epi16(segment, _mm_setzero_si128()), _mm_set1_epi16(0x100));
+    CONST __m128i mantissa = _mm_slli_epi16(_mm_and_si128(xValue, _mm_set1_epi16(0x0F)), 4);
+
+    CONST __m128i magnitude = ShiftG711(_mm_add_epi16(_mm_add_epi16(mantissa, _mm_set1_epi16(8)), leading),
+        _mm_subs_epu16(segment, _mm_set1_epi16(1)));
+
+    // Negative samples have the sign bit clear.
+    CONST __m128i negative = _mm_cmpeq_epi16(_mm_and_si128(xValue, _mm_set1_epi16(0x80)), _mm_setzero_si128());
+
+    return _mm_sub_epi16(_mm_xor_si128(magnitude, negative), negative);
+}
+
+// Expands sixteen samples at a time in SSE2 registers, the table takes the rest.
+VOID ExpandG711(WORD wFormatTag, CONST BYTE* lpInput, LPSHORT lpOutput, DWORD dwCount) {
+    CONST __m128i zero = _mm_setzero_si128();
+
+    DWORD i = 0;
+
+    if (wFormatTag == WAVE_FORMAT_MULAW) {
+        for (; i + 16 <= dwCount; i += 16) {
+            CONST __m128i input = _mm_loadu_si128((CONST __m128i*)&lpInput[i]);
+            _mm_storeu_si128((__m128i*)&lpOutput[i], ExpandMuLawLanes(_mm_unpacklo_epi8(input, zero)));
+            _mm_storeu_si128((__m128i*)&lpOutput[i + 8], ExpandMuLawLanes(_mm_unpackhi_epi8(input, zero)));
+        }
+    }
+    else {
+        for (; i + 16 <= dwCount; i += 16) {
+            CONST __m128i input = _mm_loadu_si128((CONST __m128i*)&lpInput[i]);
+            _mm_storeu_si128((__m128i*)&lpOutput[i], ExpandALawLanes(_mm_unpacklo_epi8(input, zero)));
+            _mm_storeu_si128((__m128i*)&lpOutput[i + 8], ExpandALawLanes(_mm_unpackhi_epi8(input, zero)));
+        }
+    }
+
+    CONST SHORT* table = wFormatTag == WAVE_FORMAT_MULAW ? MuLawTable : ALawTable;
+
+    for (; i < dwCount; i++) {
+        lpOutput[i] = table[lpInput[i]];
+    }
+}
+
+// Converts four float samples into 32-bit PCM. NaNs are silenced and samples past full scale
+// are clipped, 2147483520 is the largest float below 2^31.
+static inline __m128i ConvertFloatLanes(__m128 xValue) {
+    xValue = _mm_and_ps(xValue, _mm_cmpord_ps(xValue, xValue));
+    xValue = _mm_mul_ps(xValue, _mm_set1_ps(2147483648.0f));
+
+    return _mm_cvtps_epi32(_mm_max_ps(_mm_min_ps(xValue, _mm_set1_ps(2147483520.0f)), _mm_set1_ps(-2147483648.0f)));
+}
+
+VOID ConvertFloatSamples(CONST float* lpInput, LPINT lpOutput, DWORD dwCount) {
+    DWORD i = 0;
+
+    for (; i + 4 <= dwCount; i += 4) {
+        _mm_storeu_si128((__m128i*)&lpOutput[i], ConvertFloatLanes(_mm_loadu_ps(&lpInput[i])));
+    }
+
+    // The rest goes through the same lanes, so that it is rounded and clipped the same way.
+    if (i < dwCount) {
+        float input[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        INT output[4];
+
+        CopyMemory(input, &lpInput[i], (dwCount - i) * sizeof(float));
+        _mm_storeu_si128((__m128i*)output, ConvertFloatLanes(_mm_loadu_ps(input)));
+        CopyMemory(&lpOutput[i], output, (dwCount - i) * sizeof(INT));
+    }
+}
+
+SHORT ClampSample(INT nValue) {
+    return (SHORT)(nValue < -32768 ? -32768 : (32767 < nValue ? 32767 : nValue));
+}
+
+SHORT DecodeImaNibble(INT nNibble, INT* lpPredictor, INT* lpIndex) {
+    CONST INT step = ImaStepTable[*lpIndex];
+
+    INT diff = step >> 3;
+    if (nNibble & 4) { diff += step; }
+    if (nNibble & 2) { diff += step >> 1; }
+    if (nNibble & 1) { diff += step >> 2; }
+
+    *lpPredictor = ClampSample((nNibble & 8) ? *lpPredictor - diff : *lpPredictor + diff);
+    *lpIndex = max(0, min(IMA_ADPCM_MAX_INDEX, *lpIndex + ImaIndexTable[nNibble & 7]));
+
+    return (SHORT)*lpPredictor;
+}
+
+DWORD GetImaAdpcmFrames(DWORD dwBytes, WORD nChannels) {
+    CONST DWORD header = 4 * nChannels;
+
+    return dwBytes < header ? 0 : 1 + (dwBytes - header) / header * 8;
+}
+
+DWORD DecodeImaAdpcmBlock(CONST BYTE* lpInput, DWORD dwSize,
+    WORD nChannels, LPSHORT lpOutput, DWORD dwFrames) {
+    CONST DWORD frames = min(dwFrames, GetImaAdpcmFrames(dwSize, nChannels));
+
+    if (frames == 0) { return 0; }
+
+    INT predictor[MAX_CODEC_CHANNELS];
+    INT index[MAX_CODEC_CHANNELS];
+
+    // Each channel starts with the initial sample and step index.
+    for (WORD c = 0; c < nChannels; c++) {
+        CONST BYTE* header = &lpInput[c * 4];
+
+        predictor[c] = (SHORT)(header[0] | (header[1] << 8));
+        index[c] = min(header[2], IMA_ADPCM_MAX_INDEX);
+
+        lpOutput[c] = (SHORT)predictor[c];
+    }
+
+    // Then channels interleave in groups of 4 bytes, 8 samples each, low nibble first.
+    CONST BYTE* data = &lpInput[nChannels * 4];
+
+    for (DWORD group = 0; 1 + group * 8 < frames; group++) {
+        for (WORD c = 0; c < nChannels; c++) {
+            CONST BYTE* bytes = &data[(group * nChannels + c) * 4];
+
+            for (DWORD i = 0; i < 8; i++) {
+                CONST DWORD frame = 1 + group * 8 + i;
+
+                if (frames <= frame) { break; }
+
+                CONST INT nibble = (i & 1) ? bytes[i >> 1] >> 4 : bytes[i >> 1] & 0x0F;
+
+                lpOutput[frame * nChannels + c] =
+                    DecodeImaNibble(nibble, &predictor[c], &index[c]);
+            }
+        }
+    }
+
+    return frames;
+}
+
+DWORD GetMsAdpcmFrames(DWORD dwBytes, WORD nChannels) {
+    CONST DWORD header = 7 * nChannels;
+
+    return dwBytes < header ? 0 : 2 + (dwBytes - header) * 2 / nChannels;
+}
+
+DWORD DecodeMsAdpcmBlock(WAVECODECPTR lpCodec, CONST BYTE* lpInput, DWORD dwSize,
+    WORD nChannels, LPSHORT lpOutput, DWORD dwFrames) {
+    CONST DWORD frames = min(dwFrames, GetMsAdpcmFrames(dwSize, nChannels));
+
+    if (frames == 0) { return 0; }
+
+    INT coef1[MAX_CODEC_CHANNELS], coef2[MAX_CODEC_CHANNELS];
+    INT delta[MAX_CODEC_CHANNELS];
+    INT sample1[MAX_CODEC_CHANNELS], sample2[MAX_CODEC_CHANNELS];
+
+    // Block header holds predictors, deltas and two initial samples for each channel.
+    for (WORD c = 0; c < nChannels; c++) {
+        CONST BYTE predictor = min(lpInput[c], lpCodec->nNumCoef - 1);
+
+        coef1[c] = lpCodec->aCoef[predictor].iCoef1;
+        coef2[c] = lpCodec->aCoef[predictor].iCoef2;
+
+        CONST BYTE* value = &lpInput[nChannels + c * 2];
+        delta[c] = (SHORT)(value[0] | (value[1] << 8));
+
+        value = &lpInput[nChannels * 3 + c * 2];
+        sample1[c] = (SHORT)(value[0] | (value[1] << 8));
+
+        value = &lpInput[nChannels * 5 + c * 2];
+        sample2[c] = (SHORT)(value[0] | (value[1] << 8));
+
+        // The older sample is played first.
+        lpOutput[c] = (SHORT)sample2[c];
+
+        if (1 < frames) { lpOutput[nChannels + c] = (SHORT)sample1[c]; }
+    }
+
+    // Nibbles follow interleaved across channels, high nibble first.
+    CONST BYTE* data = &lpInput[nChannels * 7];
+
+    DWORD nibbles = 0;
+    for (DWORD frame = 2; frame < frames; frame++) {
+        for (WORD c = 0; c < nChannels; c++, nibbles++) {
+            CONST INT nibble = (nibbles & 1) ? data[nibbles >> 1] & 0x0F : data[nibbles >> 1] >> 4;
+            CONST INT error = nibble & 8 ? nibble - 16 : nibble;
+
+            CONST INT predicted = (sample1[c] * coef1[c] + sample2[c] * coef2[c]) / 256;
+            CONST SHORT sample = ClampSample(predicted + error * delta[c]);
+
+            sample2[c] = sample1[c];
+            sample1[c] = sample;
+
+            delta[c] = max(MS_ADPCM_MIN_DELTA, MsAdaptationTable[nibble] * delta[c] / 256);
+
+            lpOutput[frame * nChannels + c] = sample;
+        }
+    }
+
+    return frames;
+}
+
+BOOL InitializeWaveCodec(WAVECODECPTR lpCodec,
+    CONST LPWAVEFORMATEX lpSource, DWORD dwSourceSize, LPWAVEFORMATEX lpOutput) {
+    if (lpCodec == NULL || lpSource == NULL || lpOutput == NULL) { return FALSE; }
+    if (dwSourceSize < sizeof(PCMWAVEFORMAT)) { return FALSE; }
+
+    ZeroMemory(lpCodec, sizeof(WAVECODEC));
+
+    // Extensible PCM and float samples are handled as their plain counterparts,
+    // the channel mask is not used and valid bits are taken as the whole container.
+    WORD tag = lpSource->wFormatTag;
+
+    if (tag == WAVE_FORMAT_EXTENSIBLE) {
+        if (dwSourceSize < sizeof(WAVEFORMATEXTENSIBLE)) { return FALSE; }
+
+        CONST WAVEFORMATEXTENSIBLE* extensible = (WAVEFORMATEXTENSIBLE*)lpSource;
+
+        if (IsEqualGUID(extensible->SubFormat, KSDATAFORMAT_SUBTYPE_PCM)) { tag = WAVE_FORMAT_PCM; }
+        else if (IsEqualGUID(extensible->SubFormat, KSDATAFORMAT_SUBTYPE_IEEE_FLOAT)) { tag = WAVE_FORMAT_IEEE_FLOAT; }
+        else { return FALSE; }
+    }
+
+    lpCodec->wfxSource.wFormatTag = tag;
+    lpCodec->wfxSource.nChannels = lpSource->nChannels;
+    lpCodec->wfxSource.nSamplesPerSec = lpSource->nSamplesPerSec;
+    lpCodec->wfxSource.nAvgBytesPerSec = lpSource->nAvgBytesPerSec;
+    lpCodec->wfxSource.nBlockAlign = lpSource->nBlockAlign;
+    lpCodec->wfxSource.wBitsPerSample = lpSource->wBitsPerSample;
+
+    CONST WORD channels = lpSource->nChannels;
+
+    if (channels == 0 || lpSource->nBlockAlign == 0) { return FALSE; }
+
+    // Compressed formats are decoded into 16-bit PCM.
+    lpOutput->wFormatTag = WAVE_FORMAT_PCM;
+    lpOutput->nChannels = channels;
+    lpOutput->nSamplesPerSec = lpSource->nSamplesPerSec;
+    lpOutput->wBitsPerSample = 16;
+    lpOutput->nBlockAlign = channels * sizeof(SHORT);
+    lpOutput->nAvgBytesPerSec = lpOutput->nSamplesPerSec * lpOutput->nBlockAlign;
+    lpOutput->cbSize = 0;
+
+    switch (tag) {
+    case WAVE_FORMAT_PCM:
+        lpOutput->wBitsPerSample = lpSource->wBitsPerSample;
+        lpOutput->nBlockAlign = lpSource->nBlockAlign;
+        lpOutput->nAvgBytesPerSec = lpSource->nAvgBytesPerSec;
+
+        lpCodec->nFramesPerBlock = 1;
+
+        return TRUE;
+    case WAVE_FORMAT_IEEE_FLOAT:
+        // Float samples are converted into 32-bit PCM, which dithering and scrubbing handle.
+        if (lpSource->wBitsPerSample != 32 || lpSource->nBlockAlign != channels * sizeof(float)) { return FALSE; }
+
+        lpOutput->wBitsPerSample = 32;
+        lpOutput->nBlockAlign = channels * sizeof(INT);
+        lpOutput->nAvgBytesPerSec = lpOutput->nSamplesPerSec * lpOutput->nBlockAlign;
+
+        lpCodec->nFramesPerBlock = 1;
+
+        return TRUE;
+    case WAVE_FORMAT_MULAW:
+    case WAVE_FORMAT_ALAW:
+        if (lpSource->wBitsPerSample != 8 || lpSource->nBlockAlign != channels) { return FALSE; }
+
+        lpCodec->nFramesPerBlock = 1;
+
+        return TRUE;
+    case WAVE_FORMAT_IMA_ADPCM:
+        if (lpSource->wBitsPerSample != 4 || MAX_CODEC_CHANNELS < channels) { return FALSE; }
+
+        // Data past the header comes in groups of 4 bytes per channel.
+        if (lpSource->nBlockAlign <= 4 * channels
+            || (lpSource->nBlockAlign - 4 * channels) % (4 * channels) != 0) {
+            return FALSE;
+        }
+
+        lpCodec->nFramesPerBlock = GetImaAdpcmFrames(lpSource->nBlockAlign, channels);
+
+        break;
+    case WAVE_FORMAT_ADPCM: {
+        if (lpSource->wBitsPerSample != 4 || MAX_CODEC_CHANNELS < channels) { return FALSE; }
+        if (lpSource->nBlockAlign < 7 * channels) { return FALSE; }
+        if (dwSourceSize < sizeof(ADPCMWAVEFORMAT)) { return FALSE; }
+
+        CONST ADPCMWAVEFORMAT* format = (ADPCMWAVEFORMAT*)lpSource;
+
+        if (format->wNumCoef == 0 || MAX_ADPCM_COEFFICIENTS < format->wNumCoef) { return FALSE; }
+        if (dwSourceSize < sizeof(ADPCMWAVEFORMAT) + format->wNumCoef * sizeof(ADPCMCOEFSET)) {
+            return FALSE;
+        }
+
+        lpCodec->nNumCoef = format->wNumCoef;
+        CopyMemory(lpCodec->aCoef, format->aCoef, format->wNumCoef * sizeof(ADPCMCOEFSET));
+
+        lpCodec->nFramesPerBlock = GetMsAdpcmFrames(lpSource->nBlockAlign, channels);
+
+        break;
+    }
+    default:
+        return FALSE;
+    }
+
+    // ADPCM decodes a whole block at a time, keep the last one for subsequent reads.
+    lpCodec->lpBlock = (LPSHORT)AllocateMemory((size_t)lpCodec->nFramesPerBlock * channels * sizeof(SHORT));
+    lpCodec->dwBlock = MAXDWORD;
+
+    return lpCodec->lpBlock != NULL;
+}
+
+VOID ReleaseWaveCodec(WAVECODECPTR lpCodec) {
+    if (lpCodec == NULL) { return; }
+
+    FreeMemory(lpCodec->lpBlock);
+    lpCodec->lpBlock = NULL;
+}
+
+DWORD GetWaveCodecFrames(WAVECODECPTR lpCodec, DWORD dwBytes) {
+    if (lpCodec == NULL) { return 0; }
+
+    CONST WORD align = lpCodec->wfxSource.nBlockAlign;
+    CONST WORD channels = lpCodec->wfxSource.nChannels;
+
+    switch (lpCodec->wfxSource.wFormatTag) {
+    case WAVE_FORMAT_IMA_ADPCM:
+        return dwBytes / align * lpCodec->nFramesPerBlock
+            + GetImaAdpcmFrames(dwBytes % align, channels);
+    case WAVE_FORMAT_ADPCM:
+        return dwBytes / align * lpCodec->nFramesPerBlock
+            + GetMsAdpcmFrames(dwBytes % align, channels);
+    }
+
+    return dwBytes / align;
+}
+
+VOID DecodeWaveFrames(WAVECODECPTR lpCodec, LPCVOID lpData, DWORD dwDataSize,
+    DWORD dwFrame, DWORD dwFrames, LPVOID lpOutput) {
+    CONST WORD align = lpCodec->wfxSource.nBlockAlign;
+    CONST WORD channels = lpCodec->wfxSource.nChannels;
+    CONST BYTE* data = (CONST BYTE*)lpData;
+
+    switch (lpCodec->wfxSource.wFormatTag) {
+    case WAVE_FORMAT_PCM:
+        CopyMemory(lpOutput, &data[(size_t)dwFrame * align], (size_t)dwFrames * align);
+        return;
+    case WAVE_FORMAT_MULAW:
+        ExpandG711(WAVE_FORMAT_MULAW, &data[(size_t)dwFrame * align], (LPSHORT)lpOutput, dwFrames * channels);
+        return;
+    case WAVE_FORMAT_ALAW:
+        ExpandG711(WAVE_FORMAT_ALAW, &data[(size_t)dwFrame * align], (LPSHORT)lpOutput, dwFrames * channels);
+        return;
+    case WAVE_FORMAT_IEEE_FLOAT:
+        ConvertFloatSamples((CONST float*)&data[(size_t)dwFrame * align], (LPINT)lpOutput, dwFrames * channels);
+        return;
+    }
+
+    // Blocks have a fixed size, so any frame maps directly to its block.
+    LPSHORT output = (LPSHORT)lpOutput;
+
+    while (dwFrames != 0) {
+        CONST DWORD block = dwFrame / lpCodec->nFramesPerBlock;
+        CONST DWORD offset = dwFrame % lpCodec->nFramesPerBlock;
+
+        if (lpCodec->dwBlock != block) {
+            CONST DWORD start = block * align;
+            CONST DWORD size = start < dwDataSize ? min(align, dwDataSize - start) : 0;
+
+            CONST DWORD decoded = lpCodec->wfxSource.wFormatTag == WAVE_FORMAT_IMA_ADPCM
+                ? DecodeImaAdpcmBlock(&data[start], size, channels, lpCodec->lpBlock, lpCodec->nFramesPerBlock)
+                : DecodeMsAdpcmBlock(lpCodec, &data[start], size, channels, lpCodec->lpBlock, lpCodec->nFramesPerBlock);
+
+            // Truncated block is padded with silence.
+            ZeroMemory(&lpCodec->lpBlock[decoded * channels],
+                (lpCodec->nFramesPerBlock - decoded) * channels * sizeof(SHORT));
+
+            lpCodec->dwBlock = block;
+        }
+
+        CONST DWORD frames = min(dwFrames, lpCodec->nFramesPerBlock - offset);
+
+        CopyMemory(output, &lpCodec->lpBlock[offset * channels], frames * channels * sizeof(SHORT));
+
+        output += frames * channels;
+        dwFrame += frames;
+        dwFrames -= frames;
+    }
+}
\ No newline at end of file
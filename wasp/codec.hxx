@@ -0,0 +1,48 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <windows.h>
+#include <mmreg.h>
+
+#define MAX_ADPCM_COEFFICIENTS  32
+
+typedef struct WaveCodec {
+    WAVEFORMATEX            wfxSource;          // Format of the sample data as stored in memory, extensible formats by their plain tags.
+    DWORD                   nFramesPerBlock;    // ADPCM blocks of up to 64KB hold more than a WORD of frames.
+    WORD                    nNumCoef;           // MS ADPCM Only
+    ADPCMCOEFSET            aCoef[MAX_ADPCM_COEFFICIENTS];
+
+    LPSHORT                 lpBlock;            // Most recently decoded ADPCM block.
+    DWORD                   dwBlock;            // Index of the decoded block, MAXDWORD if none.
+} WAVECODEC, * WAVECODECPTR;
+
+VOID InitializeCodecs();
+
+BOOL InitializeWaveCodec(WAVECODECPTR lpCodec,
+    CONST LPWAVEFORMATEX lpSource, DWORD dwSourceSize, LPWAVEFORMATEX lpOutput);
+VOID ReleaseWaveCodec(WAVECODECPTR lpCodec);
+
+DWORD GetWaveCodecFrames(WAVECODECPTR lpCodec, DWORD dwBytes);
+VOID DecodeWaveFrames(WAVECODECPTR lpCodec, LPCVOID lpData, DWORD dwDataSize,
+    DWORD dwFrame, DWORD dwFrames, LPVOID lpOutput);
\ No newline at end of file
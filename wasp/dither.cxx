@@ -0,0 +1,205 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <emmintrin.h>
+
+#include "dither.hxx"
+
+// Error feedback filters, the noise is shaped by 1 - (c1 z^-1 + c2 z^-2 + ...).
+CONST float DitherCoefs[DITHERSHAPE_COUNT][MAX_DITHER_TAPS] = {
+    { 0.0f },
+    { 1.0f },
+    { 2.0f, -1.0f },
+    { 2.033f, -2.165f, 1.959f, -1.590f, 0.6149f }
+};
+
+CONST UINT32 DitherTaps[DITHERSHAPE_COUNT] = { 0, 1, 2, 5 };
+
+BOOL IsDitherSupported(CONST LPWAVEFORMATEX lpFormat) {
+    if (lpFormat == NULL) { return FALSE; }
+    if (lpFormat->wFormatTag != WAVE_FORMAT_PCM) { return FALSE; }
+    if (lpFormat->nChannels == 0 || MAX_DITHER_CHANNELS < lpFormat->nChannels) { return FALSE; }
+    if (lpFormat->wBitsPerSample != 24 && lpFormat->wBitsPerSample != 32) { return FALSE; }
+
+    return lpFormat->nBlockAlign == lpFormat->nChannels * (lpFormat->wBitsPerSample >> 3);
+}
+
+BOOL InitializeDither(DITHERPTR lpDither, CONST LPWAVEFORMATEX lpFormat, DITHERSHAPE dwShape) {
+    if (lpDither == NULL || !IsDitherSupported(lpFormat)) { return FALSE; }
+    if (DITHERSHAPE_COUNT <= dwShape) { return FALSE; }
+
+    ZeroMemory(lpDither, sizeof(DITHER));
+
+    lpDither->nChannels = lpFormat->nChannels;
+    lpDither->nBlockAlign = lpFormat->nBlockAlign;
+    lpDither->wBitsPerSample = lpFormat->wBitsPerSample;
+    // Lipshitz filter follows the hearing curve at 44.1 kHz, higher rates are
+    // better off pushing the noise past the audible range instead.
+    if (dwShape == DITHERSHAPE_LIPSHITZ && 48000 < lpFormat->nSamplesPerSec) {
+        dwShape = DITHERSHAPE_SECOND_ORDER;
+    }
+
+    lpDither->dwShape = dwShape;
+    lpDither->nNumTaps = DitherTaps[dwShape];
+
+    CopyMemory(lpDither->aCoef, DitherCoefs[dwShape], sizeof(lpDither->aCoef));
+
+    // Every lane needs its own non-zero seed, or channels get correlated noise.
+    UINT32 seed = 0x9E3779B9;
+    for (UINT32 g = 0; g < MAX_DITHER_CHANNELS / 4; g++) {
+        for (UINT32 l = 0; l < 4; l++) {
+            seed = seed * 1664525 + 1013904223;
+            lpDither->aSeed[g][l] = seed | 1;
+        }
+    }
+
+    return TRUE;
+}
+
+// Converts source samples into floats, in steps of 16-bit samples.
+VOID ReadDitherInput(DITHERPTR lpDither, CONST BYTE* lpInput, UINT32 nSamples) {
+    CONST float scale = 1.0f / 65536.0f;
+    float* input = lpDither->aInput;
+
+    if (lpDither->wBitsPerSample == 32) {
+        CONST __m128 factor = _mm_set1_ps(scale);
+
+        UINT32 i = 0;
+        for (; i + 4 <= nSamples; i += 4) {
+            CONST __m128i samples = _mm_loadu_si128((CONST __m128i*)&lpInput[i * sizeof(INT)]);
+            _mm_storeu_ps(&input[i], _mm_mul_ps(_mm_cvtepi32_ps(samples), factor));
+        }
+
+        for (; i < nSamples; i++) {
+            input[i] = (float)*(CONST INT*)&lpInput[i * sizeof(INT)] * scale;
+        }
+
+        return;
+    }
+
+    for (UINT32 i = 0; i < nSamples; i++) {
+        CONST BYTE* sample = &lpInput[i * 3];
+        input[i] = (float)(INT)((sample[0] << 8) | (sample[1] << 16) | (sample[2] << 24)) * scale;
+    }
+}
+
+// Packs quantized samples into 16 bits, saturating the ones pushed past full scale.
+VOID WriteDitherOutput(DITHERPTR lpDither, SHORT* lpOutput, UINT32 nSamples) {
+    CONST INT* output = lpDither->aOutput;
+
+    UINT32 i = 0;
+    for (; i + 8 <= nSamples; i += 8) {
+        CONST __m128i low = _mm_loadu_si128((CONST __m128i*)&output[i]);
+        CONST __m128i high = _mm_loadu_si128((CONST __m128i*)&output[i + 4]);
+        _mm_storeu_si128((__m128i*)&lpOutput[i], _mm_packs_epi32(low, high));
+    }
+
+    for (; i < nSamples; i++) {
+        lpOutput[i] = (SHORT)min(max(output[i], -32768), 32767);
+    }
+}
+
+// Uniform random numbers in [-0.5, 0.5), one per lane.
+__m128 NextDitherRandom(__m128i* lpSeed) {
+    __m128i x = *lpSeed;
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+    *lpSeed = x;
+
+    return _mm_mul_ps(_mm_cvtepi32_ps(x), _mm_set1_ps(1.0f / 4294967296.0f));
+}
+
+// Quantizes a block of four channels, all frames in a row, so that the
+// error feedback of each channel stays in a register of its lane.
+VOID DitherChannels(DITHERPTR lpDither, UINT32 nGroup, UINT32 nFrames) {
+    CONST UINT32 channels = lpDither->nChannels;
+    CONST UINT32 first = nGroup * 4;
+    CONST UINT32 taps = lpDither->nNumTaps;
+
+    // Lanes past the last channel must not overwrite channels of the next frame.
+    CONST __m128i mask = _mm_cmplt_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32((INT)(channels - first)));
+
+    __m128 coef[MAX_DITHER_TAPS], error[MAX_DITHER_TAPS];
+    for (UINT32 k = 0; k < MAX_DITHER_TAPS; k++) {
+        coef[k] = _mm_set1_ps(lpDither->aCoef[k]);
+        error[k] = _mm_loadu_ps(lpDither->aError[nGroup][k]);
+    }
+
+    __m128i seed = _mm_loadu_si128((CONST __m128i*)lpDither->aSeed[nGroup]);
+
+    for (UINT32 i = 0; i < nFrames; i++) {
+        CONST UINT32 offset = i * channels + first;
+
+        // Subtract the filtered error of previous samples, so that it ends up shaped.
+        __m128 wanted = _mm_loadu_ps(&lpDither->aInput[offset]);
+        for (UINT32 k = 0; k < taps; k++) {
+            wanted = _mm_sub_ps(wanted, _mm_mul_ps(coef[k], error[k]));
+        }
+
+        // Sum of two uniform random numbers gives triangular dither of +/- 1 step.
+        CONST __m128 dither = _mm_add_ps(NextDitherRandom(&seed), NextDitherRandom(&seed));
+        CONST __m128i quantized = _mm_cvtps_epi32(_mm_add_ps(wanted, dither));
+
+        for (UINT32 k = taps; k > 1; k--) {
+            error[k - 1] = error[k - 2];
+        }
+
+        error[0] = _mm_sub_ps(_mm_cvtepi32_ps(quantized), wanted);
+
+        __m128i* output = (__m128i*)&lpDither->aOutput[offset];
+        CONST __m128i previous = _mm_loadu_si128(output);
+        _mm_storeu_si128(output,
+            _mm_or_si128(_mm_and_si128(mask, quantized), _mm_andnot_si128(mask, previous)));
+    }
+
+    for (UINT32 k = 0; k < MAX_DITHER_TAPS; k++) {
+        _mm_storeu_ps(lpDither->aError[nGroup][k], error[k]);
+    }
+
+    _mm_storeu_si128((__m128i*)lpDither->aSeed[nGroup], seed);
+}
+
+// Reduces 24 or 32-bit source frames to 16 bits, with TPDF dither and noise shaping.
+VOID DitherFrames(DITHERPTR lpDither, LPCVOID lpInput, UINT32 nFrames, LPVOID lpOutput) {
+    if (lpDither == NULL || lpDither->nChannels == 0) { return; }
+
+    CONST BYTE* input = (CONST BYTE*)lpInput;
+    SHORT* output = (SHORT*)lpOutput;
+
+    while (nFrames != 0) {
+        CONST UINT32 frames = min(nFrames, DITHER_BLOCK_SIZE);
+        CONST UINT32 samples = frames * lpDither->nChannels;
+
+        ReadDitherInput(lpDither, input, samples);
+
+        for (UINT32 g = 0; g * 4 < lpDither->nChannels; g++) {
+            DitherChannels(lpDither, g, frames);
+        }
+
+        WriteDitherOutput(lpDither, output, samples);
+
+        input += frames * lpDither->nBlockAlign;
+        output += samples;
+        nFrames -= frames;
+    }
+}
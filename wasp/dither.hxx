@@ -0,0 +1,61 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <windows.h>
+#include <mmreg.h>
+
+#define MAX_DITHER_CHANNELS     8
+#define MAX_DITHER_TAPS         5
+#define DITHER_BLOCK_SIZE       256         // In Frames
+
+typedef enum DitherShape {
+    DITHERSHAPE_NONE        = 0,            // Flat TPDF dither without noise shaping.
+    DITHERSHAPE_FIRST_ORDER = 1,            // Noise rises by 6 dB per octave.
+    DITHERSHAPE_SECOND_ORDER= 2,            // Noise rises by 12 dB per octave.
+    DITHERSHAPE_LIPSHITZ    = 3,            // Five tap E-weighted filter, designed for 44.1 kHz.
+    DITHERSHAPE_COUNT       = 4,
+    DITHERSHAPE_FORCE_DWORD = 0x7FFFFFFF
+} DITHERSHAPE, * DITHERSHAPEPTR;
+
+typedef struct Dither {
+    WORD                    nChannels;
+    WORD                    nBlockAlign;        // Of the source frames.
+    WORD                    wBitsPerSample;     // Of the source samples, 24 or 32.
+    DITHERSHAPE             dwShape;
+    UINT32                  nNumTaps;
+    float                   aCoef[MAX_DITHER_TAPS];
+
+    // Channels are processed four at a time, each one in its own lane.
+    // Error feedback and random number state carry over from one buffer to the next.
+    float                   aError[MAX_DITHER_CHANNELS / 4][MAX_DITHER_TAPS][4];
+    UINT32                  aSeed[MAX_DITHER_CHANNELS / 4][4];
+
+    float                   aInput[DITHER_BLOCK_SIZE * MAX_DITHER_CHANNELS + 4];  // In 16-bit Steps
+    INT                     aOutput[DITHER_BLOCK_SIZE * MAX_DITHER_CHANNELS + 4];
+} DITHER, * DITHERPTR;
+
+BOOL IsDitherSupported(CONST LPWAVEFORMATEX lpFormat);
+
+BOOL InitializeDither(DITHERPTR lpDither, CONST LPWAVEFORMATEX lpFormat, DITHERSHAPE dwShape);
+VOID DitherFrames(DITHERPTR lpDither, LPCVOID lpInput, UINT32 nFrames, LPVOID lpOutput);
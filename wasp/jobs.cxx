@@ -0,0 +1,336 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "jobs.hxx"
+#include "mem.hxx"
+
+#define MAX_JOB_WORKERS 16
+
+typedef struct JobQueue {
+    CRITICAL_SECTION        csLock;
+    JOBPTR                  lpHead;
+    JOBPTR                  lpTail;
+} JOBQUEUE, * JOBQUEUEPTR;
+
+typedef struct JobWorker {
+    HANDLE                  hThread;
+    JOBQUEUE                aQueues[JOBPRIORITY_COUNT];
+} JOBWORKER, * JOBWORKERPTR;
+
+static JOBWORKER Workers[MAX_JOB_WORKERS];
+static UINT32 WorkerCount;
+static DWORD WorkerSlot = TLS_OUT_OF_INDEXES;
+
+// Jobs submitted from outside of the workers.
+static JOBQUEUE Queues[JOBPRIORITY_COUNT];
+
+// Counts jobs in all of the queues, every taken job is preceded by a wait on it.
+static HANDLE Semaphore;
+static HANDLE Exit;
+
+static BOOL Initialized;
+static volatile LONG Session;
+static JOBMETRICS Metrics;
+
+VOID InitializeJobQueue(JOBQUEUEPTR lpQueue) {
+    InitializeCriticalSection(&lpQueue->csLock);
+    lpQueue->lpHead = NULL;
+    lpQueue->lpTail = NULL;
+}
+
+VOID PushJobQueue(JOBQUEUEPTR lpQueue, JOBPTR lpJob) {
+    lpJob->lpNext = NULL;
+
+    EnterCriticalSection(&lpQueue->csLock);
+
+    if (lpQueue->lpTail != NULL) { lpQueue->lpTail->lpNext = lpJob; }
+    else { lpQueue->lpHead = lpJob; }
+
+    lpQueue->lpTail = lpJob;
+
+    LeaveCriticalSection(&lpQueue->csLock);
+}
+
+JOBPTR PopJobQueue(JOBQUEUEPTR lpQueue) {
+    if (lpQueue->lpHead == NULL) { return NULL; }
+
+    EnterCriticalSection(&lpQueue->csLock);
+
+    JOBPTR job = lpQueue->lpHead;
+
+    if (job != NULL) {
+        lpQueue->lpHead = job->lpNext;
+
+        if (lpQueue->lpHead == NULL) { lpQueue->lpTail = NULL; }
+    }
+
+    LeaveCriticalSection(&lpQueue->csLock);
+
+    return job;
+}
+
+// Returns index of the calling worker, or WorkerCount for any other thread.
+UINT32 GetWorkerIndex() {
+    if (WorkerSlot == TLS_OUT_OF_INDEXES) { return WorkerCount; }
+
+    CONST UINT32 index = (UINT32)(size_t)TlsGetValue(WorkerSlot);
+
+    return index == 0 ? WorkerCount : index - 1;
+}
+
+VOID PushJob(JOBPTR lpJob) {
+    CONST UINT32 worker = GetWorkerIndex();
+
+    // Workers keep the jobs they submit, for the others to steal when idle.
+    PushJobQueue(worker < WorkerCount
+        ? &Workers[worker].aQueues[lpJob->dwPriority] : &Queues[lpJob->dwPriority], lpJob);
+
+    InterlockedIncrement(&Metrics.nPending[lpJob->dwPriority]);
+    ReleaseSemaphore(Semaphore, 1, NULL);
+}
+
+JOBPTR TakeJob() {
+    CONST UINT32 worker = GetWorkerIndex();
+
+    // The semaphore guarantees there is a job, but another thread
+    // may be in the middle of pushing it, so keep looking until it shows up.
+    for (;;) {
+        for (UINT32 p = 0; p < JOBPRIORITY_COUNT; p++) {
+            JOBPTR job = NULL;
+
+            if (worker < WorkerCount) {
+                job = PopJobQueue(&Workers[worker].aQueues[p]);
+            }
+
+            if (job == NULL) { job = PopJobQueue(&Queues[p]); }
+
+            // Steal from the other workers, starting with the next one.
+            for (UINT32 i = 1; job == NULL && i <= WorkerCount; i++) {
+                CONST UINT32 victim = (worker + i) % (WorkerCount + 1);
+
+                if (victim < WorkerCount) {
+                    job = PopJobQueue(&Workers[victim].aQueues[p]);
+                }
+            }
+
+            if (job != NULL) { return job; }
+        }
+
+        YieldProcessor();
+    }
+}
+
+DWORD GetJobLatency(JOBPTR lpJob) {
+    LARGE_INTEGER now, frequency;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+
+    return (DWORD)((now.QuadPart - lpJob->liSubmitTime.QuadPart) * 1000000 / frequency.QuadPart);
+}
+
+VOID RunJob(JOBPTR lpJob) {
+    CONST JOBPRIORITY priority = lpJob->dwPriority;
+    CONST LONG latency = (LONG)GetJobLatency(lpJob);
+
+    InterlockedDecrement(&Metrics.nPending[priority]);
+    InterlockedExchangeAdd64(&Metrics.nTotalLatency[priority], latency);
+
+    LONG highest = Metrics.nMaxLatency[priority];
+    while (highest < latency) {
+        CONST LONG value = InterlockedCompareExchange(&Metrics.nMaxLatency[priority], latency, highest);
+
+        if (value == highest) { break; }
+
+        highest = value;
+    }
+
+    if (lpJob->lpProc(lpJob->lpParameter, lpJob)) {
+        QueryPerformanceCounter(&lpJob->liSubmitTime);
+        PushJob(lpJob);
+        return;
+    }
+
+    InterlockedIncrement(&Metrics.nCompleted[priority]);
+    FreeMemory(lpJob);
+}
+
+DWORD WINAPI JobWorkerMain(LPVOID lpThreadParameter) {
+    TlsSetValue(WorkerSlot, lpThreadParameter);
+
+    CONST HANDLE handles[] = { Exit, Semaphore };
+
+    while (WaitForMultipleObjects(ARRAYSIZE(handles), handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1) {
+        RunJob(TakeJob());
+    }
+
+    return EXIT_SUCCESS;
+}
+
+BOOL InitializeJobs(UINT32 nWorkers, DWORD_PTR dwReservedAffinity) {
+    ZeroMemory(&Metrics, sizeof(JOBMETRICS));
+
+    for (UINT32 p = 0; p < JOBPRIORITY_COUNT; p++) {
+        InitializeJobQueue(&Queues[p]);
+    }
+
+    Initialized = TRUE;
+
+    WorkerSlot = TlsAlloc();
+
+    if (WorkerSlot == TLS_OUT_OF_INDEXES) { return FALSE; }
+
+    Semaphore = CreateSemaphoreA(NULL, 0, MAXLONG, NULL);
+    Exit = CreateEventA(NULL, TRUE, FALSE, NULL);
+
+    if (Semaphore == NULL || Exit == NULL) {
+        ReleaseJobs();
+        return FALSE;
+    }
+
+    // Keep workers away from the cores reserved for the audio thread.
+    DWORD_PTR process = 0, system = 0;
+    GetProcessAffinityMask(GetCurrentProcess(), &process, &system);
+
+    CONST DWORD_PTR affinity = process & ~dwReservedAffinity;
+
+    nWorkers = min(max(nWorkers, 1), MAX_JOB_WORKERS);
+
+    for (UINT32 i = 0; i < nWorkers; i++) {
+        for (UINT32 p = 0; p < JOBPRIORITY_COUNT; p++) {
+            InitializeJobQueue(&Workers[i].aQueues[p]);
+        }
+    }
+
+    WorkerCount = nWorkers;
+
+    for (UINT32 i = 0; i < nWorkers; i++) {
+        Workers[i].hThread = CreateThread(NULL, 0, JobWorkerMain, (LPVOID)(size_t)(i + 1), CREATE_SUSPENDED, NULL);
+
+        if (Workers[i].hThread == NULL) {
+            ReleaseJobs();
+            return FALSE;
+        }
+
+        if (affinity != 0) { SetThreadAffinityMask(Workers[i].hThread, affinity); }
+
+        // Background work must not compete with the playback.
+        SetThreadPriority(Workers[i].hThread, THREAD_PRIORITY_BELOW_NORMAL);
+        ResumeThread(Workers[i].hThread);
+    }
+
+    return TRUE;
+}
+
+VOID ReleaseJobs() {
+    if (!Initialized) { return; }
+
+    // Cancelled jobs still run, so that they can release their resources.
+    CancelJobs();
+
+    if (Exit != NULL) { SetEvent(Exit); }
+
+    for (UINT32 i = 0; i < WorkerCount; i++) {
+        if (Workers[i].hThread != NULL) {
+            WaitForSingleObject(Workers[i].hThread, INFINITE);
+            CloseHandle(Workers[i].hThread);
+            Workers[i].hThread = NULL;
+        }
+    }
+
+    // Drain whatever the workers left behind on the calling thread.
+    if (Semaphore != NULL) {
+        while (RunPendingJob()) {}
+    }
+
+    for (UINT32 i = 0; i < WorkerCount; i++) {
+        for (UINT32 p = 0; p < JOBPRIORITY_COUNT; p++) {
+            DeleteCriticalSection(&Workers[i].aQueues[p].csLock);
+        }
+    }
+
+    for (UINT32 p = 0; p < JOBPRIORITY_COUNT; p++) {
+        DeleteCriticalSection(&Queues[p].csLock);
+    }
+
+    WorkerCount = 0;
+    Initialized = FALSE;
+
+    if (Semaphore != NULL) { CloseHandle(Semaphore); Semaphore = NULL; }
+    if (Exit != NULL) { CloseHandle(Exit); Exit = NULL; }
+
+    if (WorkerSlot != TLS_OUT_OF_INDEXES) {
+        TlsFree(WorkerSlot);
+        WorkerSlot = TLS_OUT_OF_INDEXES;
+    }
+}
+
+BOOL SubmitJob(JOBPROC lpProc, LPVOID lpParameter, JOBPRIORITY dwPriority) {
+    if (lpProc == NULL || Semaphore == NULL) { return FALSE; }
+    if (JOBPRIORITY_COUNT <= dwPriority) { return FALSE; }
+
+    JOBPTR job = (JOBPTR)AllocateMemory(sizeof(JOB));
+
+    if (job == NULL) { return FALSE; }
+
+    job->lpProc = lpProc;
+    job->lpParameter = lpParameter;
+    job->dwPriority = dwPriority;
+    job->nSession = Session;
+
+    QueryPerformanceCounter(&job->liSubmitTime);
+
+    PushJob(job);
+
+    return TRUE;
+}
+
+BOOL RunPendingJob() {
+    if (Semaphore == NULL) { return FALSE; }
+    if (WaitForSingleObject(Semaphore, 0) != WAIT_OBJECT_0) { return FALSE; }
+
+    RunJob(TakeJob());
+
+    return TRUE;
+}
+
+VOID CancelJobs() {
+    InterlockedIncrement(&Session);
+}
+
+BOOL IsJobCancelled(JOBPTR lpJob) {
+    if (lpJob == NULL) { return FALSE; }
+
+    return lpJob->nSession != Session;
+}
+
+// Moves the job into the current session, so that it is no longer cancelled.
+VOID RenewJob(JOBPTR lpJob) {
+    if (lpJob == NULL) { return; }
+
+    lpJob->nSession = Session;
+}
+
+VOID GetJobMetrics(JOBMETRICSPTR lpMetrics) {
+    if (lpMetrics == NULL) { return; }
+
+    CopyMemory(lpMetrics, &Metrics, sizeof(JOBMETRICS));
+}
\ No newline at end of file
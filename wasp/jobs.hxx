@@ -0,0 +1,65 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <windows.h>
+
+typedef enum JobPriority {
+    JOBPRIORITY_LOAD        = 0,            // Loading of the track being played.
+    JOBPRIORITY_PREFETCH    = 1,            // Loading of the tracks that may be played next.
+    JOBPRIORITY_COUNT       = 2,
+    JOBPRIORITY_FORCE_DWORD = 0x7FFFFFFF
+} JOBPRIORITY, * JOBPRIORITYPTR;
+
+typedef struct Job* JOBPTR;
+
+// Returns TRUE to run the job again, at the priority stored in the job.
+typedef BOOL(*JOBPROC)(LPVOID lpParameter, JOBPTR lpJob);
+
+typedef struct Job {
+    JOBPROC                 lpProc;
+    LPVOID                  lpParameter;
+    JOBPRIORITY             dwPriority;
+    LONG                    nSession;           // Session the job was submitted in.
+    LARGE_INTEGER           liSubmitTime;
+    JOBPTR                  lpNext;
+} JOB;
+
+typedef struct JobMetrics {
+    LONG                    nPending[JOBPRIORITY_COUNT];
+    LONG                    nCompleted[JOBPRIORITY_COUNT];
+    LONGLONG                nTotalLatency[JOBPRIORITY_COUNT];  // In Microseconds, from submission to start.
+    LONG                    nMaxLatency[JOBPRIORITY_COUNT];    // In Microseconds
+} JOBMETRICS, * JOBMETRICSPTR;
+
+BOOL InitializeJobs(UINT32 nWorkers, DWORD_PTR dwReservedAffinity);
+VOID ReleaseJobs();
+
+BOOL SubmitJob(JOBPROC lpProc, LPVOID lpParameter, JOBPRIORITY dwPriority);
+BOOL RunPendingJob();
+
+VOID CancelJobs();
+BOOL IsJobCancelled(JOBPTR lpJob);
+VOID RenewJob(JOBPTR lpJob);
+
+VOID GetJobMetrics(JOBMETRICSPTR lpMetrics);
\ No newline at end of file
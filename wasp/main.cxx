@@ -25,6 +25,8 @@ SOFTWARE.
 #include <commctrl.h>
 #include <strsafe.h>
 
+#include "cache.hxx"
+#include "jobs.hxx"
 #include "mem.hxx"
 #include "wasapi.hxx"
 #include "wasp.hxx"
@@ -35,6 +37,19 @@ SOFTWARE.
 #define MAX_STATUS_BAR_TEXT_LENGTH  128
 #define DEFAULT_STATUS_BAR_TEXT     "00:00:00 / 00:00:00"
 
+#define WAVE_CACHE_BUDGET           (1024 * 1024 * 1024)
+#define WAVE_CACHE_CAPACITY         16
+#define WAVE_CACHE_WARM_UP          TRUE
+#define WAVE_CACHE_FLAGS            0           // WAVE_FLAG_COMPRESS trades decoding time for memory.
+
+#define AUDIO_DITHER                TRUE
+#define AUDIO_DITHER_SHAPE          DITHERSHAPE_LIPSHITZ
+
+#define STATUS_BAR_METRICS          FALSE       // Latency of the playback session next to its position.
+
+#define RESERVE_AUDIO_CORE          TRUE
+#define MIN_RESERVED_CORE_COUNT     3
+
 HWND WND;
 HWND Button;
 
@@ -46,6 +61,7 @@ HWND StatusBar;
 CHAR StatusBarText[MAX_STATUS_BAR_TEXT_LENGTH] = DEFAULT_STATUS_BAR_TEXT;
 
 AUDIOPTR Audio;
+WAVECACHEPTR Cache;
 
 VOID UpdateStatusBar() {
     CHAR text[MAX_STATUS_BAR_TEXT_LENGTH];
@@ -53,16 +69,51 @@ VOID UpdateStatusBar() {
     CONST DWORD elapsed = GetAudioPosition(Audio);
     CONST DWORD total = GetAudioLength(Audio);
 
-    StringCchPrintfA(text, 128, "%02d:%02d:%02d / %02d:%02d:%02d",
+    StringCchPrintfA(text, MAX_STATUS_BAR_TEXT_LENGTH, "%02d:%02d:%02d / %02d:%02d:%02d",
         elapsed / (60 * 60), (elapsed / 60) % 60, elapsed % 60,
         total / (60 * 60), (total / 60) % 60, total % 60);
 
+    if (STATUS_BAR_METRICS) {
+        AUDIOMETRICS audio;
+        GetAudioMetrics(Audio, &audio);
+
+        WAVEMETRICS wave;
+        GetWaveMetrics(Audio->lpWave, &wave);
+
+        // Zero stands for a metric that is not known yet.
+        CONST SIZE_T length = strlen(text);
+        StringCchPrintfA(&text[length], MAX_STATUS_BAR_TEXT_LENGTH - length,
+            "    UI blocked %.1f ms, first audio %.1f ms, loaded %.1f ms",
+            audio.dwBlockingTime / 1000.0, audio.dwFirstAudioTime / 1000.0, wave.dwLoadTime / 1000.0);
+    }
+
     if (strcmp(StatusBarText, text) != 0) {
         strcpy(StatusBarText, text);
         SendMessageA(StatusBar, SB_SETTEXT, (WPARAM)0, (LPARAM)StatusBarText);
     }
 }
 
+// Thumb position is in whole seconds, the cursor over the channel is far more precise.
+UINT64 GetTrackBarFrame() {
+    RECT channel, thumb;
+    SendMessageA(TrackBar, TBM_GETCHANNELRECT, 0, (LPARAM)&channel);
+    SendMessageA(TrackBar, TBM_GETTHUMBRECT, 0, (LPARAM)&thumb);
+
+    CONST DWORD position = GetMessagePos();
+    POINT cursor = { GET_X_LPARAM(position), GET_Y_LPARAM(position) };
+    ScreenToClient(TrackBar, &cursor);
+
+    // Center of the thumb travels between the ends of the channel, inset by half of the thumb.
+    CONST LONG inset = (thumb.right - thumb.left) / 2;
+    CONST LONG width = channel.right - channel.left - 2 * inset;
+
+    if (width <= 0) { return 0; }
+
+    CONST LONG offset = min(max(cursor.x - channel.left - inset, 0), width);
+
+    return (UINT64)Audio->lpWave->dwNumFrames * offset / width;
+}
+
 VOID UpdateTrackBar() {
     CONST DWORD elapsed = GetAudioPosition(Audio);
     CONST DWORD total = GetAudioLength(Audio);
@@ -78,8 +129,8 @@ VOID UpdateTrackBar() {
     }
 }
 
-BOOL ActivatePlayback(WAVEPTR lpWav) {
-    if (PlayAudio(Audio, lpWav)) {
+BOOL ActivatePlayback(WAVEPTR lpWav, UINT64 nRequestTime) {
+    if (PlayAudio(Audio, lpWav, nRequestTime)) {
         EnableWindow(TrackBar, TRUE);
         UpdateTrackBar();
         return TRUE;
@@ -92,6 +143,8 @@ BOOL ActivatePlayback(WAVEPTR lpWav) {
 }
 
 VOID ResumePlayback() {
+    // Opening another file may have cancelled loading of the current one.
+    LoadWaveAsync(Audio->lpWave, JOBPRIORITY_LOAD);
     ResumeAudio(Audio);
 
     strcpy(StatusBarText, DEFAULT_STATUS_BAR_TEXT);
@@ -114,6 +167,8 @@ VOID DisablePlayback() {
 VOID OpenFile(LPCSTR lpszPath) {
     if (lpszPath == NULL) { return; }
 
+    CONST UINT64 request = GetCurrentTime100ns();
+
     // If file was selected, check if it is different from the current file, if any.
     if (IsAudioPresent(Audio)) {
         // Check if the selected file is the same as currently open file.
@@ -126,11 +181,23 @@ VOID OpenFile(LPCSTR lpszPath) {
         DisablePlayback();
     }
 
-    // Attempt to open a wav file.
-    WAVEPTR wav = OpenWave(lpszPath);
+    // Background work of the previous file is no longer urgent, partially loaded
+    // waves resume loading when they are opened again.
+    CancelJobs();
+
+    // Attempt to open a wav file, recently opened files are served from the cache.
+    WAVEPTR wav = OpenCachedWave(Cache, lpszPath, JOBPRIORITY_LOAD);
     if (wav != NULL) {
         // If the selected file is a valid wav file - play it immediately.
-        ActivatePlayback(wav);
+        if (ActivatePlayback(wav, request)) {
+            WarmUpWaveCache(Cache, lpszPath);
+            return;
+        }
+    }
+
+    // Current wave is kept when the new one fails, so its loading has to go on.
+    if (IsAudioPresent(Audio)) {
+        LoadWaveAsync(Audio->lpWave, JOBPRIORITY_LOAD);
     }
 }
 
@@ -204,6 +271,20 @@ LRESULT WINAPI WaspWndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         if (TrackBar == (HWND)lParam) {
             if (IsAudioPresent(Audio)) {
                 CONST DWORD action = LOWORD(wParam);
+
+                // Dragging the thumb scrubs through the track, playback continues
+                // from where the thumb is released.
+                if (action == TB_THUMBTRACK && ScrubAudio(Audio, GetTrackBarFrame())) {
+                    UpdateStatusBar();
+                    return 0;
+                }
+
+                if (IsAudioScrubbing(Audio)) {
+                    if (action == TB_ENDTRACK) { EndAudioScrub(Audio); }
+
+                    return 0;
+                }
+
                 CONST DWORD position = action == TB_THUMBPOSITION || action == TB_THUMBTRACK
                     ? HIWORD(wParam) : (DWORD)SendMessageA(TrackBar, TBM_GETPOS, 0, 0);
 
@@ -270,6 +351,29 @@ HWND CreateWaspButton(HINSTANCE hInstance, HWND hWnd, LPCSTR text, int x, int y,
     return button;
 }
 
+// Returns the affinity mask of the core reserved for the audio thread, or 0.
+DWORD_PTR GetReservedAudioAffinity(UINT32* lpCores) {
+    DWORD_PTR process = 0, system = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) { process = 0; }
+
+    UINT32 cores = 0;
+    DWORD_PTR highest = 0;
+
+    for (DWORD_PTR mask = 1; mask != 0; mask <<= 1) {
+        if (process & mask) {
+            cores++;
+            highest = mask;
+        }
+    }
+
+    *lpCores = max(cores, 1);
+
+    // Reserving a core on small machines costs more than it saves.
+    if (!RESERVE_AUDIO_CORE || cores < MIN_RESERVED_CORE_COUNT) { return 0; }
+
+    return highest;
+}
+
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nShowCmd) {
     // Initialize.
     if (FAILED(CoInitializeEx(NULL, COINIT_SPEED_OVER_MEMORY))) {
@@ -278,10 +382,29 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     }
 
     InitializeMemory();
+    InitializeCodecs();
+
+    UINT32 cores = 0;
+    CONST DWORD_PTR reserved = GetReservedAudioAffinity(&cores);
+
+    // Jobs are optional, waves are loaded on the calling thread when there are no workers.
+    InitializeJobs(reserved != 0 ? cores - 1 : cores, reserved);
+
     Audio = InitializeAudio();
 
+    if (Audio != NULL) {
+        Audio->dwAffinity = reserved;
+        Audio->bDither = AUDIO_DITHER;
+        Audio->dwDitherShape = AUDIO_DITHER_SHAPE;
+    }
+
+    // Cache is optional, files are opened directly when it is not available.
+    Cache = InitializeWaveCache(WAVE_CACHE_BUDGET, WAVE_CACHE_CAPACITY, WAVE_CACHE_FLAGS, WAVE_CACHE_WARM_UP);
+
     if (Audio == NULL) {
         MessageBoxA(NULL, "Can't initialize WASAPI!", WINDOW_NAME, MB_ICONERROR | MB_OK);
+        ReleaseJobs();
+        ReleaseWaveCache(Cache);
         CoUninitialize();
         return EXIT_FAILURE;
     }
@@ -325,7 +448,9 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         if (active) {
             if (IsAudioPresent(Audio)) {
                 UpdateStatusBar();
-                UpdateTrackBar();
+
+                // The thumb follows the mouse while scrubbing.
+                if (!IsAudioScrubbing(Audio)) { UpdateTrackBar(); }
             }
 
             Sleep(1);
@@ -337,6 +462,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         ReleaseAudio(Audio);
     }
 
+    // Jobs refer to the cached waves, stop them first.
+    ReleaseJobs();
+    ReleaseWaveCache(Cache);
+
+    // Waves released without job workers are freed by their loader threads.
+    WaitForWaveLoaders(INFINITE);
+
     CoUninitialize();
 
     return EXIT_SUCCESS;
@@ -0,0 +1,171 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <math.h>
+
+#include "scrub.hxx"
+
+#define SCRUB_GRAIN_IN_SECONDS      (1.0f / 100.0f)
+#define SCRUB_MAX_SPEED             4.0f        // Thumb moving faster makes the read head jump instead.
+#define SCRUB_SPEED_SMOOTHING       0.25f       // Thumb moves in steps of a mouse message, a few hops apart.
+#define SCRUB_FULL_GAIN_SPEED       0.25f       // Grains played slower than this fade out.
+
+#define SCRUB_PI                    3.14159265358979323846
+
+float ReadScrubSample(CONST BYTE* lpSample, WORD wBitsPerSample) {
+    switch (wBitsPerSample) {
+    case 8: return ((INT)lpSample[0] - 128) * (1.0f / 128.0f);
+    case 16: return *(CONST SHORT*)lpSample * (1.0f / 32768.0f);
+    case 24: return ((INT)((lpSample[0] << 8) | (lpSample[1] << 16) | (lpSample[2] << 24)) >> 8) * (1.0f / 8388608.0f);
+    }
+
+    return (float)(*(CONST INT*)lpSample * (1.0 / 2147483648.0));
+}
+
+VOID WriteScrubSample(BYTE* lpSample, WORD wBitsPerSample, float fValue) {
+    CONST double scale = (double)(1u << (wBitsPerSample - 1));
+    CONST double value = floor(min(max(fValue * scale, -scale), scale - 1.0) + 0.5);
+
+    switch (wBitsPerSample) {
+    case 8: lpSample[0] = (BYTE)((INT)value + 128); break;
+    case 16: *(SHORT*)lpSample = (SHORT)value; break;
+    case 24: {
+        CONST INT sample = (INT)value;
+        lpSample[0] = (BYTE)sample;
+        lpSample[1] = (BYTE)(sample >> 8);
+        lpSample[2] = (BYTE)(sample >> 16);
+        break;
+    }
+    default: *(INT*)lpSample = (INT)value; break;
+    }
+}
+
+BOOL InitializeScrub(SCRUBPTR lpScrub, CONST LPWAVEFORMATEX lpFormat) {
+    if (lpScrub == NULL || lpFormat == NULL) { return FALSE; }
+
+    lpScrub->nGrainSize = 0;
+
+    if (lpFormat->wFormatTag != WAVE_FORMAT_PCM) { return FALSE; }
+    if (lpFormat->nChannels == 0 || MAX_SCRUB_CHANNELS < lpFormat->nChannels) { return FALSE; }
+
+    CONST WORD bits = lpFormat->wBitsPerSample;
+    if (bits != 8 && bits != 16 && bits != 24 && bits != 32) { return FALSE; }
+    if (lpFormat->nBlockAlign != lpFormat->nChannels * (bits >> 3)) { return FALSE; }
+
+    lpScrub->nChannels = lpFormat->nChannels;
+    lpScrub->nBlockAlign = lpFormat->nBlockAlign;
+    lpScrub->wBitsPerSample = bits;
+
+    // Grain size is even, so that two halves of overlapping windows sum up to one.
+    CONST UINT32 grain = (UINT32)(lpFormat->nSamplesPerSec * SCRUB_GRAIN_IN_SECONDS) & ~1u;
+
+    lpScrub->nGrainSize = min(max(grain, 2), MAX_SCRUB_GRAIN_SIZE);
+    lpScrub->nHopSize = lpScrub->nGrainSize / 2;
+
+    for (UINT32 i = 0; i < lpScrub->nGrainSize; i++) {
+        lpScrub->aWindow[i] = (float)(0.5 - 0.5 * cos(2.0 * SCRUB_PI * i / lpScrub->nGrainSize));
+    }
+
+    ResetScrub(lpScrub, 0);
+
+    return TRUE;
+}
+
+VOID ResetScrub(SCRUBPTR lpScrub, UINT64 nFrame) {
+    if (lpScrub == NULL) { return; }
+
+    lpScrub->fPosition = (double)nFrame;
+    lpScrub->fTarget = (double)nFrame;
+    lpScrub->fSpeed = 0.0f;
+
+    ZeroMemory(lpScrub->aOverlap, sizeof(lpScrub->aOverlap));
+}
+
+// Writes a single hop of output, mixing a new grain at the read head
+// with the second half of the previous one. Returns the number of frames written.
+UINT32 RenderScrub(SCRUBPTR lpScrub, WAVEPTR lpWav, UINT64 nTarget, LPVOID lpOutput) {
+    if (lpScrub == NULL || lpScrub->nGrainSize == 0) { return 0; }
+
+    CONST UINT32 hop = lpScrub->nHopSize;
+    CONST WORD channels = lpScrub->nChannels;
+    CONST WORD bytes = lpScrub->wBitsPerSample >> 3;
+
+    // Speed follows how far the thumb moved since the previous hop.
+    CONST float distance = (float)(((double)nTarget - lpScrub->fTarget) / hop);
+    CONST float speed = min(max(distance, -SCRUB_MAX_SPEED), SCRUB_MAX_SPEED);
+
+    lpScrub->fSpeed += (speed - lpScrub->fSpeed) * SCRUB_SPEED_SMOOTHING;
+    lpScrub->fTarget = (double)nTarget;
+
+    // Read head that fell more than a grain away from the thumb jumps onto it,
+    // the overlap of the previous grain crossfades into the new one.
+    if (lpScrub->nGrainSize < fabs((double)nTarget - lpScrub->fPosition)) {
+        lpScrub->fPosition = (double)nTarget;
+    }
+
+    // Grains fade out as the thumb comes to rest, holding it still is silent.
+    CONST float gain = min(fabsf(lpScrub->fSpeed) / SCRUB_FULL_GAIN_SPEED, 1.0f);
+
+    // Grain is centered on the read head, frames outside of what is loaded are silent.
+    CONST INT64 start = (INT64)lpScrub->fPosition - hop;
+    CONST INT64 end = start + lpScrub->nGrainSize;
+    CONST INT64 loaded = GetWaveLoadedFrames(lpWav);
+
+    CONST INT64 first = min(max(start, 0), loaded);
+    CONST INT64 last = min(max(end, 0), loaded);
+
+    // Silence of 8-bit audio is in the middle of the unsigned range.
+    FillMemory(lpScrub->aGrain, (size_t)lpScrub->nGrainSize * lpScrub->nBlockAlign,
+        lpScrub->wBitsPerSample == 8 ? 0x80 : 0);
+
+    if (first < last) {
+        ReadWaveFrames(lpWav, (DWORD)first, (DWORD)(last - first),
+            &lpScrub->aGrain[(first - start) * lpScrub->nBlockAlign]);
+    }
+
+    BYTE* output = (BYTE*)lpOutput;
+
+    for (UINT32 i = 0; i < hop; i++) {
+        CONST BYTE* head = &lpScrub->aGrain[i * lpScrub->nBlockAlign];
+        CONST BYTE* next = &lpScrub->aGrain[(i + hop) * lpScrub->nBlockAlign];
+
+        CONST float wh = lpScrub->aWindow[i] * gain;
+        CONST float wt = lpScrub->aWindow[i + hop] * gain;
+
+        for (WORD c = 0; c < channels; c++) {
+            float* overlap = &lpScrub->aOverlap[i * channels + c];
+
+            WriteScrubSample(&output[(i * channels + c) * bytes], lpScrub->wBitsPerSample,
+                *overlap + ReadScrubSample(&head[c * bytes], lpScrub->wBitsPerSample) * wh);
+
+            *overlap = ReadScrubSample(&next[c * bytes], lpScrub->wBitsPerSample) * wt;
+        }
+    }
+
+    // Read head keeps moving between mouse messages, but never strays more than a grain from the thumb.
+    CONST double position = min(max(lpScrub->fPosition + (double)lpScrub->fSpeed * hop,
+        (double)nTarget - lpScrub->nGrainSize), (double)nTarget + lpScrub->nGrainSize);
+
+    lpScrub->fPosition = min(max(position, 0.0), (double)lpWav->dwNumFrames);
+
+    return hop;
+}
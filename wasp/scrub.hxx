@@ -0,0 +1,48 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "wave.hxx"
+
+#define MAX_SCRUB_CHANNELS          8
+#define MAX_SCRUB_GRAIN_SIZE        4096        // In Frames
+
+typedef struct Scrub {
+    WORD                    nChannels;
+    WORD                    nBlockAlign;
+    WORD                    wBitsPerSample;     // 8, 16, 24 or 32
+    UINT32                  nGrainSize;         // In Frames, 0 when the format can not be scrubbed.
+    UINT32                  nHopSize;           // In Frames, grains overlap by half of their size.
+
+    double                  fPosition;          // Read head, in Frames of the wave.
+    double                  fTarget;            // Thumb position at the previous hop, in Frames of the wave.
+    float                   fSpeed;             // In Frames of the wave per Frame of output.
+
+    float                   aWindow[MAX_SCRUB_GRAIN_SIZE];
+    float                   aOverlap[MAX_SCRUB_GRAIN_SIZE / 2 * MAX_SCRUB_CHANNELS];
+    BYTE                    aGrain[MAX_SCRUB_GRAIN_SIZE * MAX_SCRUB_CHANNELS * sizeof(INT)];
+} SCRUB, * SCRUBPTR;
+
+BOOL InitializeScrub(SCRUBPTR lpScrub, CONST LPWAVEFORMATEX lpFormat);
+VOID ResetScrub(SCRUBPTR lpScrub, UINT64 nFrame);
+UINT32 RenderScrub(SCRUBPTR lpScrub, WAVEPTR lpWav, UINT64 nTarget, LPVOID lpOutput);
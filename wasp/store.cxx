@@ -0,0 +1,400 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "mem.hxx"
+#include "store.hxx"
+
+// Blocks are small enough to be decoded just ahead of the play cursor.
+#define STORE_FRAMES_PER_BLOCK  4096
+
+// Rice parameter is chosen separately for each partition of a channel.
+#define RICE_PARTITION_SIZE     256
+#define RICE_PARAMETER_BITS     5
+#define RICE_MAX_PARAMETER      30
+
+// Residuals with a longer unary quotient are stored verbatim.
+#define RICE_ESCAPE             24
+
+#define MAX_PREDICTOR_ORDER     3
+#define PREDICTOR_ORDER_BITS    2
+
+typedef struct BitWriter {
+    LPBYTE                  lpData;
+    size_t                  nPosition;          // In Bytes
+    UINT64                  nBits;
+    UINT32                  nCount;             // Number of pending bits.
+} BITWRITER, * BITWRITERPTR;
+
+typedef struct BitReader {
+    CONST BYTE*             lpData;
+    size_t                  nSize;              // In Bytes
+    size_t                  nPosition;          // In Bytes
+    UINT64                  nBits;
+    UINT32                  nCount;             // Number of pending bits.
+} BITREADER, * BITREADERPTR;
+
+VOID WriteBits(BITWRITERPTR lpWriter, UINT32 nValue, UINT32 nCount) {
+    lpWriter->nBits = (lpWriter->nBits << nCount) | (nValue & ((1ULL << nCount) - 1));
+    lpWriter->nCount += nCount;
+
+    while (8 <= lpWriter->nCount) {
+        lpWriter->nCount -= 8;
+        lpWriter->lpData[lpWriter->nPosition++] = (BYTE)(lpWriter->nBits >> lpWriter->nCount);
+    }
+}
+
+VOID FlushBits(BITWRITERPTR lpWriter) {
+    if (lpWriter->nCount != 0) {
+        lpWriter->lpData[lpWriter->nPosition++] = (BYTE)(lpWriter->nBits << (8 - lpWriter->nCount));
+        lpWriter->nCount = 0;
+    }
+}
+
+UINT32 ReadBits(BITREADERPTR lpReader, UINT32 nCount) {
+    while (lpReader->nCount < nCount) {
+        CONST BYTE value = lpReader->nPosition < lpReader->nSize
+            ? lpReader->lpData[lpReader->nPosition++] : 0;
+
+        lpReader->nBits = (lpReader->nBits << 8) | value;
+        lpReader->nCount += 8;
+    }
+
+    lpReader->nCount -= nCount;
+
+    return (UINT32)((lpReader->nBits >> lpReader->nCount) & ((1ULL << nCount) - 1));
+}
+
+UINT32 ZigZag(INT nValue) {
+    return ((UINT32)nValue << 1) ^ (UINT32)(nValue >> 31);
+}
+
+INT UnZigZag(UINT32 nValue) {
+    return (INT)(nValue >> 1) ^ -(INT)(nValue & 1);
+}
+
+INT PredictSample(CONST INT* lpSamples, DWORD dwIndex, UINT32 nOrder) {
+    switch (nOrder) {
+    case 1: return lpSamples[dwIndex - 1];
+    case 2: return 2 * lpSamples[dwIndex - 1] - lpSamples[dwIndex - 2];
+    case 3: return 3 * lpSamples[dwIndex - 1] - 3 * lpSamples[dwIndex - 2] + lpSamples[dwIndex - 3];
+    }
+
+    return 0;
+}
+
+VOID EncodeChannel(BITWRITERPTR lpWriter, CONST INT* lpSamples, DWORD dwFrames) {
+    // Pick the fixed polynomial predictor with the smallest residuals.
+    UINT64 errors[MAX_PREDICTOR_ORDER + 1] = { 0 };
+
+    for (DWORD i = MAX_PREDICTOR_ORDER; i < dwFrames; i++) {
+        for (UINT32 o = 0; o <= MAX_PREDICTOR_ORDER; o++) {
+            CONST INT residual = lpSamples[i] - PredictSample(lpSamples, i, o);
+            errors[o] += ZigZag(residual);
+        }
+    }
+
+    UINT32 order = 0;
+    for (UINT32 o = 1; o <= MAX_PREDICTOR_ORDER; o++) {
+        if (errors[o] < errors[order]) { order = o; }
+    }
+
+    order = min(order, dwFrames);
+
+    WriteBits(lpWriter, order, PREDICTOR_ORDER_BITS);
+
+    // Warm-up samples are stored verbatim.
+    for (DWORD i = 0; i < order; i++) {
+        WriteBits(lpWriter, (UINT32)lpSamples[i], 32);
+    }
+
+    for (DWORD start = order; start < dwFrames; start += RICE_PARTITION_SIZE) {
+        CONST DWORD end = min(dwFrames, start + RICE_PARTITION_SIZE);
+
+        UINT64 sum = 0;
+        for (DWORD i = start; i < end; i++) {
+            sum += ZigZag(lpSamples[i] - PredictSample(lpSamples, i, order));
+        }
+
+        // Parameter close to the log2 of the mean residual.
+        UINT32 k = 0;
+        while (k < RICE_MAX_PARAMETER && ((UINT64)(end - start) << (k + 1)) < sum) { k++; }
+
+        WriteBits(lpWriter, k, RICE_PARAMETER_BITS);
+
+        for (DWORD i = start; i < end; i++) {
+            CONST UINT32 value = ZigZag(lpSamples[i] - PredictSample(lpSamples, i, order));
+            CONST UINT32 quotient = value >> k;
+
+            if (quotient < RICE_ESCAPE) {
+                WriteBits(lpWriter, ((1U << quotient) - 1) << 1, quotient + 1);
+                WriteBits(lpWriter, value, k);
+            }
+            else {
+                WriteBits(lpWriter, (1U << RICE_ESCAPE) - 1, RICE_ESCAPE);
+                WriteBits(lpWriter, value, 32);
+            }
+        }
+    }
+}
+
+VOID DecodeChannel(BITREADERPTR lpReader, LPINT lpSamples, DWORD dwFrames) {
+    CONST UINT32 bits = ReadBits(lpReader, PREDICTOR_ORDER_BITS);
+    CONST UINT32 order = min(bits, dwFrames);
+
+    for (DWORD i = 0; i < order; i++) {
+        lpSamples[i] = (INT)ReadBits(lpReader, 32);
+    }
+
+    for (DWORD start = order; start < dwFrames; start += RICE_PARTITION_SIZE) {
+        CONST DWORD end = min(dwFrames, start + RICE_PARTITION_SIZE);
+        CONST UINT32 k = ReadBits(lpReader, RICE_PARAMETER_BITS);
+
+        for (DWORD i = start; i < end; i++) {
+            UINT32 quotient = 0;
+            while (quotient < RICE_ESCAPE && ReadBits(lpReader, 1) != 0) { quotient++; }
+
+            CONST UINT32 value = quotient < RICE_ESCAPE
+                ? (quotient << k) | ReadBits(lpReader, k) : ReadBits(lpReader, 32);
+
+            lpSamples[i] = UnZigZag(value) + PredictSample(lpSamples, i, order);
+        }
+    }
+}
+
+BOOL IsSampleStoreSupported(CONST LPWAVEFORMATEX lpFormat) {
+    if (lpFormat == NULL) { return FALSE; }
+    if (lpFormat->wFormatTag != WAVE_FORMAT_PCM || lpFormat->nChannels == 0) { return FALSE; }
+    if (lpFormat->wBitsPerSample != 16 && lpFormat->wBitsPerSample != 24) { return FALSE; }
+
+    return lpFormat->nBlockAlign == lpFormat->nChannels * (lpFormat->wBitsPerSample >> 3);
+}
+
+BOOL InitializeSampleStore(SAMPLESTOREPTR lpStore, CONST LPWAVEFORMATEX lpFormat, DWORD dwFrames) {
+    if (lpStore == NULL) { return FALSE; }
+
+    ZeroMemory(lpStore, sizeof(SAMPLESTORE));
+
+    if (!IsSampleStoreSupported(lpFormat)) { return FALSE; }
+
+    lpStore->nChannels = lpFormat->nChannels;
+    lpStore->nBlockAlign = lpFormat->nBlockAlign;
+    lpStore->wBitsPerSample = lpFormat->wBitsPerSample;
+    lpStore->nNumFrames = dwFrames;
+    lpStore->nFramesPerBlock = STORE_FRAMES_PER_BLOCK;
+    lpStore->nNumBlocks = (dwFrames + STORE_FRAMES_PER_BLOCK - 1) / STORE_FRAMES_PER_BLOCK;
+    lpStore->dwDecoded = MAXDWORD;
+
+    CONST size_t samples = (size_t)STORE_FRAMES_PER_BLOCK * lpStore->nChannels;
+
+    lpStore->lpBlocks = (LPBYTE*)AllocateMemory(lpStore->nNumBlocks * sizeof(LPBYTE));
+    lpStore->lpBlockSizes = (LPDWORD)AllocateMemory(lpStore->nNumBlocks * sizeof(DWORD));
+
+    lpStore->lpEncodeChannels = (LPINT)AllocateMemory(samples * sizeof(INT));
+    lpStore->lpDecodeChannels = (LPINT)AllocateMemory(samples * sizeof(INT));
+
+    // Escaped residuals take RICE_ESCAPE + 32 bits, which is under 8 bytes.
+    lpStore->lpEncodeBuffer = (LPBYTE)AllocateMemory(samples * 8 + 64 * lpStore->nChannels);
+    lpStore->lpDecoded = (LPBYTE)AllocateMemory((size_t)STORE_FRAMES_PER_BLOCK * lpStore->nBlockAlign);
+
+    if (lpStore->lpBlocks == NULL || lpStore->lpBlockSizes == NULL
+        || lpStore->lpEncodeChannels == NULL || lpStore->lpDecodeChannels == NULL
+        || lpStore->lpEncodeBuffer == NULL || lpStore->lpDecoded == NULL) {
+        ReleaseSampleStore(lpStore);
+        return FALSE;
+    }
+
+    ZeroMemory(lpStore->lpBlocks, lpStore->nNumBlocks * sizeof(LPBYTE));
+    ZeroMemory(lpStore->lpBlockSizes, lpStore->nNumBlocks * sizeof(DWORD));
+
+    return TRUE;
+}
+
+// Releases the encoder buffers, no more blocks can be compressed afterwards.
+VOID CompleteSampleStore(SAMPLESTOREPTR lpStore) {
+    if (lpStore == NULL) { return; }
+
+    FreeMemory(lpStore->lpEncodeChannels);
+    FreeMemory(lpStore->lpEncodeBuffer);
+
+    lpStore->lpEncodeChannels = NULL;
+    lpStore->lpEncodeBuffer = NULL;
+}
+
+VOID ReleaseSampleStore(SAMPLESTOREPTR lpStore) {
+    if (lpStore == NULL) { return; }
+
+    if (lpStore->lpBlocks != NULL) {
+        for (DWORD i = 0; i < lpStore->nNumBlocks; i++) {
+            FreeMemory(lpStore->lpBlocks[i]);
+        }
+    }
+
+    FreeMemory(lpStore->lpBlocks);
+    FreeMemory(lpStore->lpBlockSizes);
+    FreeMemory(lpStore->lpEncodeChannels);
+    FreeMemory(lpStore->lpEncodeBuffer);
+    FreeMemory(lpStore->lpDecodeChannels);
+    FreeMemory(lpStore->lpDecoded);
+
+    ZeroMemory(lpStore, sizeof(SAMPLESTORE));
+}
+
+BOOL CompressSampleBlock(SAMPLESTOREPTR lpStore, DWORD dwBlock, LPCVOID lpInput, DWORD dwFrames) {
+    if (lpStore->nNumBlocks <= dwBlock || lpStore->nFramesPerBlock < dwFrames) { return FALSE; }
+    if (lpStore->lpEncodeChannels == NULL || lpStore->lpEncodeBuffer == NULL) { return FALSE; }
+
+    CONST WORD channels = lpStore->nChannels;
+    CONST BYTE* input = (CONST BYTE*)lpInput;
+
+    // Deinterleave samples, so that each channel is predicted on its own.
+    for (DWORD i = 0; i < dwFrames; i++) {
+        for (WORD c = 0; c < channels; c++) {
+            CONST BYTE* sample = &input[i * lpStore->nBlockAlign + c * (lpStore->wBitsPerSample >> 3)];
+
+            lpStore->lpEncodeChannels[c * dwFrames + i] = lpStore->wBitsPerSample == 16
+                ? (SHORT)(sample[0] | (sample[1] << 8))
+                : ((INT)((sample[0] << 8) | (sample[1] << 16) | (sample[2] << 24)) >> 8);
+        }
+    }
+
+    // Stereo is stored as left and side channels, which are usually better correlated.
+    if (channels == 2) {
+        for (DWORD i = 0; i < dwFrames; i++) {
+            lpStore->lpEncodeChannels[dwFrames + i] =
+                lpStore->lpEncodeChannels[i] - lpStore->lpEncodeChannels[dwFrames + i];
+        }
+    }
+
+    BITWRITER writer;
+    ZeroMemory(&writer, sizeof(BITWRITER));
+
+    writer.lpData = lpStore->lpEncodeBuffer;
+
+    for (WORD c = 0; c < channels; c++) {
+        EncodeChannel(&writer, &lpStore->lpEncodeChannels[c * dwFrames], dwFrames);
+    }
+
+    FlushBits(&writer);
+
+    LPBYTE block = (LPBYTE)AllocateMemory(writer.nPosition);
+
+    if (block == NULL) { return FALSE; }
+
+    CopyMemory(block, writer.lpData, writer.nPosition);
+
+    lpStore->lpBlockSizes[dwBlock] = (DWORD)writer.nPosition;
+    lpStore->nCompressedSize += writer.nPosition;
+    lpStore->nCompressedFrames += dwFrames;
+
+    FreeMemory(lpStore->lpBlocks[dwBlock]);
+    lpStore->lpBlocks[dwBlock] = block;
+
+    return TRUE;
+}
+
+VOID DecompressSampleBlock(SAMPLESTOREPTR lpStore, DWORD dwBlock) {
+    LARGE_INTEGER start, end, frequency;
+    QueryPerformanceCounter(&start);
+
+    CONST WORD channels = lpStore->nChannels;
+    CONST DWORD frames = min(lpStore->nFramesPerBlock,
+        lpStore->nNumFrames - dwBlock * lpStore->nFramesPerBlock);
+
+    BITREADER reader;
+    ZeroMemory(&reader, sizeof(BITREADER));
+
+    reader.lpData = lpStore->lpBlocks[dwBlock];
+    reader.nSize = reader.lpData != NULL ? lpStore->lpBlockSizes[dwBlock] : 0;
+
+    for (WORD c = 0; c < channels; c++) {
+        DecodeChannel(&reader, &lpStore->lpDecodeChannels[c * frames], frames);
+    }
+
+    if (channels == 2) {
+        for (DWORD i = 0; i < frames; i++) {
+            lpStore->lpDecodeChannels[frames + i] =
+                lpStore->lpDecodeChannels[i] - lpStore->lpDecodeChannels[frames + i];
+        }
+    }
+
+    // Interleave samples back into PCM.
+    for (DWORD i = 0; i < frames; i++) {
+        for (WORD c = 0; c < channels; c++) {
+            LPBYTE sample = &lpStore->lpDecoded[i * lpStore->nBlockAlign + c * (lpStore->wBitsPerSample >> 3)];
+            CONST INT value = lpStore->lpDecodeChannels[c * frames + i];
+
+            sample[0] = (BYTE)value;
+            sample[1] = (BYTE)(value >> 8);
+
+            if (lpStore->wBitsPerSample == 24) { sample[2] = (BYTE)(value >> 16); }
+        }
+    }
+
+    lpStore->dwDecoded = dwBlock;
+
+    QueryPerformanceCounter(&end);
+    QueryPerformanceFrequency(&frequency);
+
+    lpStore->nDecodedFrames += frames;
+    lpStore->nDecodeTime += (UINT64)(end.QuadPart - start.QuadPart) * 1000000 / frequency.QuadPart;
+}
+
+VOID ReadSampleStore(SAMPLESTOREPTR lpStore, DWORD dwFrame, DWORD dwFrames, LPVOID lpOutput) {
+    LPBYTE output = (LPBYTE)lpOutput;
+
+    // Blocks hold a fixed number of frames, so any frame maps directly to its block.
+    while (dwFrames != 0) {
+        CONST DWORD block = dwFrame / lpStore->nFramesPerBlock;
+        CONST DWORD offset = dwFrame % lpStore->nFramesPerBlock;
+
+        if (lpStore->nNumBlocks <= block) {
+            ZeroMemory(output, (size_t)dwFrames * lpStore->nBlockAlign);
+            return;
+        }
+
+        if (lpStore->dwDecoded != block) {
+            DecompressSampleBlock(lpStore, block);
+        }
+
+        CONST DWORD frames = min(dwFrames, lpStore->nFramesPerBlock - offset);
+
+        CopyMemory(output, &lpStore->lpDecoded[(size_t)offset * lpStore->nBlockAlign],
+            (size_t)frames * lpStore->nBlockAlign);
+
+        output += (size_t)frames * lpStore->nBlockAlign;
+        dwFrame += frames;
+        dwFrames -= frames;
+    }
+}
+
+VOID GetSampleStoreMetrics(SAMPLESTOREPTR lpStore, SAMPLESTOREMETRICSPTR lpMetrics) {
+    if (lpMetrics == NULL) { return; }
+
+    ZeroMemory(lpMetrics, sizeof(SAMPLESTOREMETRICS));
+
+    if (lpStore == NULL) { return; }
+
+    lpMetrics->nUncompressedSize = (size_t)lpStore->nCompressedFrames * lpStore->nBlockAlign;
+    lpMetrics->nCompressedSize = lpStore->nCompressedSize;
+    lpMetrics->nDecodedFrames = lpStore->nDecodedFrames;
+    lpMetrics->nDecodeTime = lpStore->nDecodeTime;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <windows.h>
+#include <mmreg.h>
+
+typedef struct SampleStore {
+    WORD                    nChannels;
+    WORD                    nBlockAlign;
+    WORD                    wBitsPerSample;     // 16 or 24
+    DWORD                   nNumFrames;
+    DWORD                   nFramesPerBlock;
+    DWORD                   nNumBlocks;
+
+    LPBYTE*                 lpBlocks;           // Compressed blocks, each one decodable on its own.
+    LPDWORD                 lpBlockSizes;       // In Bytes
+    size_t                  nCompressedSize;    // In Bytes, of all blocks compressed so far.
+    DWORD                   nCompressedFrames;
+
+    // Encoder buffers are released once all the blocks are compressed.
+    LPINT                   lpEncodeChannels;   // Deinterleaved samples of the block being compressed.
+    LPBYTE                  lpEncodeBuffer;     // Large enough for the worst case compressed block.
+
+    LPINT                   lpDecodeChannels;
+    LPBYTE                  lpDecoded;          // Most recently decoded block, as PCM.
+    DWORD                   dwDecoded;          // Index of the decoded block, MAXDWORD if none.
+
+    UINT64                  nDecodedFrames;
+    UINT64                  nDecodeTime;        // In Microseconds
+} SAMPLESTORE, * SAMPLESTOREPTR;
+
+typedef struct SampleStoreMetrics {
+    size_t                  nUncompressedSize;  // In Bytes, of the frames compressed so far.
+    size_t                  nCompressedSize;    // In Bytes
+    UINT64                  nDecodedFrames;
+    UINT64                  nDecodeTime;        // In Microseconds
+} SAMPLESTOREMETRICS, * SAMPLESTOREMETRICSPTR;
+
+BOOL IsSampleStoreSupported(CONST LPWAVEFORMATEX lpFormat);
+
+BOOL InitializeSampleStore(SAMPLESTOREPTR lpStore, CONST LPWAVEFORMATEX lpFormat, DWORD dwFrames);
+VOID CompleteSampleStore(SAMPLESTOREPTR lpStore);
+VOID ReleaseSampleStore(SAMPLESTOREPTR lpStore);
+
+BOOL CompressSampleBlock(SAMPLESTOREPTR lpStore, DWORD dwBlock, LPCVOID lpInput, DWORD dwFrames);
+VOID ReadSampleStore(SAMPLESTOREPTR lpStore, DWORD dwFrame, DWORD dwFrames, LPVOID lpOutput);
+
+VOID GetSampleStoreMetrics(SAMPLESTOREPTR lpStore, SAMPLESTOREMETRICSPTR lpMetrics);
\ No newline at end of file
@@ -0,0 +1,91 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "timeline.hxx"
+
+UINT64 GetCurrentTime100ns() {
+    LARGE_INTEGER now, frequency;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+
+    return (UINT64)(now.QuadPart / frequency.QuadPart) * HUNDRED_NANOSECONDS_PER_SECOND
+        + (UINT64)(now.QuadPart % frequency.QuadPart) * HUNDRED_NANOSECONDS_PER_SECOND / frequency.QuadPart;
+}
+
+VOID PublishTimeline(TIMELINEPTR lpTimeline, UINT64 nFrame, UINT64 nWrittenFrame, UINT64 nTime) {
+    // Both the audio and the UI threads publish, so acquire the odd sequence first.
+    LONG sequence;
+    do {
+        sequence = lpTimeline->nSequence;
+    } while ((sequence & 1) != 0
+        || InterlockedCompareExchange(&lpTimeline->nSequence, sequence + 1, sequence) != sequence);
+
+    lpTimeline->nFrame = nFrame;
+    lpTimeline->nWrittenFrame = nWrittenFrame;
+    lpTimeline->nTime = nTime;
+
+    InterlockedExchange(&lpTimeline->nSequence, sequence + 2);
+}
+
+// Returns the frame being heard at the moment, extrapolated from the last publication while playing.
+UINT64 GetTimelineFrame(TIMELINEPTR lpTimeline, UINT64 nNow, DWORD dwSamplesPerSec, BOOL bPlaying) {
+    LONG sequence;
+    UINT64 frame, written, time;
+    do {
+        sequence = lpTimeline->nSequence;
+        MemoryBarrier();
+
+        frame = lpTimeline->nFrame;
+        written = lpTimeline->nWrittenFrame;
+        time = lpTimeline->nTime;
+
+        MemoryBarrier();
+    } while ((sequence & 1) != 0 || sequence != lpTimeline->nSequence);
+
+    // Extrapolate from the last device clock reading to the current moment,
+    // but never past the frames that were actually written.
+    if (bPlaying) {
+        if (time < nNow) {
+            frame += (nNow - time) * dwSamplesPerSec / HUNDRED_NANOSECONDS_PER_SECOND;
+        }
+
+        frame = min(frame, written);
+    }
+
+    return frame;
+}
+
+// Returns the frame being heard, from the device position in units of the frequency since the
+// stream started, the frames submitted since then and the frame written next. The position refers
+// to the sample at the speakers, so it already includes the stream latency, subtracting
+// IAudioClient::GetStreamLatency as well would count the latency twice.
+UINT64 GetAudibleFrame(UINT64 nPosition, UINT64 nFrequency, DWORD dwSamplesPerSec,
+    UINT64 nSubmittedFrames, UINT64 nSeekFrame, UINT64 nCurrentFrame) {
+    CONST UINT64 played = min(nSubmittedFrames, nPosition / nFrequency * dwSamplesPerSec
+        + nPosition % nFrequency * dwSamplesPerSec / nFrequency);
+
+    // Whatever was submitted past the position is still queued in the stream.
+    CONST UINT64 queued = nSubmittedFrames - played;
+
+    // Queued frames may belong to the position before the last seek.
+    return nSeekFrame + queued < nCurrentFrame ? nCurrentFrame - queued : nSeekFrame;
+}
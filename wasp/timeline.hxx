@@ -0,0 +1,44 @@
+/*
+Copyright (c) 2025 Eugene Kirian
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <windows.h>
+
+#define HUNDRED_NANOSECONDS_PER_SECOND  10000000
+
+// Frame being heard at a moment of the performance counter, published by one thread
+// and read by another. Readers retry while the sequence is odd or changes under them.
+typedef struct Timeline {
+    volatile LONG           nSequence;
+    volatile UINT64         nFrame;
+    volatile UINT64         nWrittenFrame;      // Next frame to be written, the frame is never extrapolated past it.
+    volatile UINT64         nTime;              // In 100ns Units of the Performance Counter
+} TIMELINE, * TIMELINEPTR;
+
+UINT64 GetCurrentTime100ns();
+
+VOID PublishTimeline(TIMELINEPTR lpTimeline, UINT64 nFrame, UINT64 nWrittenFrame, UINT64 nTime);
+UINT64 GetTimelineFrame(TIMELINEPTR lpTimeline, UINT64 nNow, DWORD dwSamplesPerSec, BOOL bPlaying);
+
+UINT64 GetAudibleFrame(UINT64 nPosition, UINT64 nFrequency, DWORD dwSamplesPerSec,
+    UINT64 nSubmittedFrames, UINT64 nSeekFrame, UINT64 nCurrentFrame);
@@ -20,60 +20,237 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <initguid.h>
+#include <mmsystem.h>
+
 #include "mem.hxx"
 #include "wasapi.hxx"
 #include "wave.hxx"
 
+#include <ks.h>
+#include <ksmedia.h>
+
 #define TARGET_BUFFER_PADDING_IN_SECONDS  (1.0f / 60.0f)
 
 #define SAFERELEASE(x) { if (x) { x->Release(); x = NULL; } }
 
+#define SCRUB_TIMER_RESOLUTION          1       // In Milliseconds
+
+#define DITHER_OUTPUT_BITS              16
+
+// Saturates at MAXDWORD, a little over 71 minutes.
+DWORD GetAudioElapsedTime(AUDIOPTR lpAudio) {
+    CONST UINT64 now = GetCurrentTime100ns();
+    if (now <= lpAudio->nRequestTime) { return 0; }
+
+    return (DWORD)min((now - lpAudio->nRequestTime) * 1000000 / HUNDRED_NANOSECONDS_PER_SECOND, MAXDWORD);
+}
+
+VOID PublishAudioTimeline(AUDIOPTR lpAudio, UINT64 nFrame, UINT64 nTime) {
+    PublishTimeline(&lpAudio->tlTimeline, nFrame, lpAudio->nCurrentFrame, nTime);
+}
+
+VOID UpdateAudioTimeline(AUDIOPTR lpAudio) {
+    UINT64 position = 0, time = 0;
+    if (FAILED(lpAudio->lpAudioClock->GetPosition(&position, &time))) { return; }
+
+    PublishAudioTimeline(lpAudio, GetAudibleFrame(position, lpAudio->nClockFrequency,
+        lpAudio->lpWave->wfxFormat.nSamplesPerSec, lpAudio->nSubmittedFrames,
+        lpAudio->nSeekFrame, lpAudio->nCurrentFrame), time);
+}
+
+// Returns TRUE if the endpoint mixes in 16-bit integers at the given rate in shared mode,
+// so that dithered samples reach it without being resampled and requantized again.
+BOOL IsDitherEndpoint(IMMDevice* lpDevice, DWORD dwSamplesPerSec) {
+    IPropertyStore* store;
+    if (FAILED(lpDevice->OpenPropertyStore(STGM_READ, &store))) { return FALSE; }
+
+    PROPVARIANT value;
+    PropVariantInit(&value);
+
+    WORD bits = 0;
+    DWORD rate = 0;
+
+    if (SUCCEEDED(store->GetValue(PKEY_AudioEngine_DeviceFormat, &value))
+        && value.vt == VT_BLOB && sizeof(WAVEFORMATEX) <= value.blob.cbSize) {
+        CONST WAVEFORMATEX* format = (WAVEFORMATEX*)value.blob.pBlobData;
+        rate = format->nSamplesPerSec;
+
+        if (format->wFormatTag == WAVE_FORMAT_PCM) {
+            bits = format->wBitsPerSample;
+        }
+        else if (format->wFormatTag == WAVE_FORMAT_EXTENSIBLE
+            && sizeof(WAVEFORMATEXTENSIBLE) <= value.blob.cbSize) {
+            CONST WAVEFORMATEXTENSIBLE* extensible = (WAVEFORMATEXTENSIBLE*)format;
+
+            if (IsEqualGUID(extensible->SubFormat, KSDATAFORMAT_SUBTYPE_PCM)) {
+                bits = extensible->Samples.wValidBitsPerSample;
+            }
+        }
+    }
+
+    PropVariantClear(&value);
+    store->Release();
+
+    return bits == DITHER_OUTPUT_BITS && rate == dwSamplesPerSec;
+}
+
+// Reads frames of the wave into the device buffer, reducing their bit depth if needed.
+VOID ReadAudioFrames(AUDIOPTR lpAudio, UINT64 nFrame, UINT32 nFrames, BYTE* lpOutput) {
+    WAVEPTR wav = lpAudio->lpWave;
+
+    if (!lpAudio->bDithering) {
+        ReadWaveFrames(wav, (DWORD)nFrame, nFrames, lpOutput);
+        return;
+    }
+
+    CONST UINT32 capacity = sizeof(lpAudio->aStaging) / wav->wfxFormat.nBlockAlign;
+
+    while (nFrames != 0) {
+        CONST UINT32 frames = min(nFrames, capacity);
+
+        ReadWaveFrames(wav, (DWORD)nFrame, frames, lpAudio->aStaging);
+        DitherFrames(&lpAudio->dtDither, lpAudio->aStaging, frames, lpOutput);
+
+        nFrame += frames;
+        nFrames -= frames;
+        lpOutput += frames * lpAudio->wfxOutput.nBlockAlign;
+    }
+}
+
+VOID BeginAudioScrubbing(AUDIOPTR lpAudio) {
+    // Drop whatever was queued for playback, so that the first grain is heard right away.
+    lpAudio->lpAudioClient->Stop();
+    lpAudio->lpAudioClient->Reset();
+    lpAudio->lpAudioClient->Start();
+
+    lpAudio->nSubmittedFrames = 0;
+
+    ResetScrub(&lpAudio->scScrub, GetAudioFramePosition(lpAudio));
+
+    // Padding while scrubbing is too short for the default timer resolution.
+    timeBeginPeriod(SCRUB_TIMER_RESOLUTION);
+}
+
+VOID RenderAudioScrubbing(AUDIOPTR lpAudio) {
+    UINT32 padding = 0;
+    if (FAILED(lpAudio->lpAudioClient->GetCurrentPadding(&padding))) { return; }
+
+    CONST UINT32 hop = lpAudio->scScrub.nHopSize;
+
+    // Latency is bounded by the padding, that is a device period and a hop, 15ms in shared mode.
+    while (padding + hop <= lpAudio->nScrubPadding) {
+        BYTE* lock;
+        if (FAILED(lpAudio->lpAudioRenderer->GetBuffer(hop, &lock))) { break; }
+
+        // Grains are rendered in the format of the wave, the staging buffer fits a whole hop.
+        if (lpAudio->bDithering) {
+            RenderScrub(&lpAudio->scScrub, lpAudio->lpWave, (DWORD)lpAudio->nScrubFrame, lpAudio->aStaging);
+            DitherFrames(&lpAudio->dtDither, lpAudio->aStaging, hop, lock);
+        }
+        else {
+            RenderScrub(&lpAudio->scScrub, lpAudio->lpWave, (DWORD)lpAudio->nScrubFrame, lock);
+        }
+
+        lpAudio->lpAudioRenderer->ReleaseBuffer(hop, 0);
+
+        lpAudio->nSubmittedFrames += hop;
+        padding += hop;
+    }
+
+    lpAudio->nCurrentFrame = (UINT64)lpAudio->scScrub.fPosition;
+
+    PublishAudioTimeline(lpAudio, lpAudio->nCurrentFrame, GetCurrentTime100ns());
+}
+
+// Thumb may be released before the audio thread began to scrub, the seek applies either way.
+VOID EndAudioScrubbing(AUDIOPTR lpAudio, BOOL bBegun) {
+    if (bBegun) { timeEndPeriod(SCRUB_TIMER_RESOLUTION); }
+
+    // Playback continues from where the thumb was released.
+    CONST UINT64 frame = min((UINT64)(DWORD)lpAudio->nScrubFrame, (UINT64)lpAudio->lpWave->dwNumFrames);
+
+    lpAudio->nCurrentFrame = frame;
+    lpAudio->nSeekFrame = frame;
+
+    PublishAudioTimeline(lpAudio, frame, GetCurrentTime100ns());
+
+    InterlockedExchange(&lpAudio->bScrub, FALSE);
+    InterlockedExchange(&lpAudio->bScrubEnd, FALSE);
+}
+
 DWORD WINAPI AudioMain(LPVOID lpThreadParameter) {
     AUDIOPTR audio = (AUDIOPTR)lpThreadParameter;
 
     CONST UINT32 target =
         (UINT32)(audio->nBufferSize * TARGET_BUFFER_PADDING_IN_SECONDS);
 
+    BOOL scrubbing = FALSE;
+
     while (audio->dwState != AUDIOSTATE_EXIT) {
-        if (audio->dwState == AUDIOSTATE_PLAY) {
+        if (audio->bScrub) {
+            if (audio->bScrubEnd) {
+                EndAudioScrubbing(audio, scrubbing);
+                scrubbing = FALSE;
+            }
+            else {
+                if (!scrubbing) {
+                    BeginAudioScrubbing(audio);
+                    scrubbing = TRUE;
+                }
+
+                RenderAudioScrubbing(audio);
+            }
+        }
+        else if (audio->dwState == AUDIOSTATE_PLAY) {
             UINT32 padding = 0;
 
             if (SUCCEEDED(audio->lpAudioClient->GetCurrentPadding(&padding))) {
                 WAVEPTR wav = audio->lpWave;
 
-                CONST UINT32 frames =
-                    min(target - padding, wav->dwNumFrames - audio->nCurrentFrame);
+                // Do not run ahead of the background loader, wait for it instead.
+                CONST UINT32 loaded = GetWaveLoadedFrames(wav);
+                CONST UINT32 available =
+                    loaded > audio->nCurrentFrame ? (UINT32)(loaded - audio->nCurrentFrame) : 0;
+
+                CONST UINT32 frames = min(target - padding, available);
 
                 if (frames != 0) {
                     BYTE* lock;
                     if (SUCCEEDED(audio->lpAudioRenderer->GetBuffer(frames, &lock))) {
-                        LPWAVEFORMATEX format = &wav->wfxFormat;
-                        CONST size_t offset = audio->nCurrentFrame * format->nBlockAlign;
-                        CONST LPVOID source = (LPVOID)((size_t)wav->lpSamples + offset);
-
-                        CopyMemory(lock, source, frames * format->nBlockAlign);
+                        ReadAudioFrames(audio, audio->nCurrentFrame, frames, lock);
 
                         audio->nCurrentFrame += frames;
-                        audio->nCurrentSample += frames * format->nChannels;
+                        audio->nSubmittedFrames += frames;
 
                         audio->lpAudioRenderer->ReleaseBuffer(frames, 0);
 
+                        if (audio->amMetrics.dwFirstAudioTime == 0) {
+                            audio->amMetrics.dwFirstAudioTime = GetAudioElapsedTime(audio);
+                        }
+
                         if (wav->dwNumFrames <= audio->nCurrentFrame) {
                             audio->dwState = AUDIOSTATE_IDLE;
                         }
                     }
                 }
+
+                UpdateAudioTimeline(audio);
             }
         }
 
         Sleep(1);
 
+        if (scrubbing || audio->bScrub) { continue; }
+
         if (audio->dwState == AUDIOSTATE_IDLE || audio->dwState == AUDIOSTATE_PAUSE) {
             if (audio->dwState == AUDIOSTATE_IDLE) {
                 WAVEPTR wav = audio->lpWave;
                 if (wav->dwNumFrames <= audio->nCurrentFrame) {
                     audio->nCurrentFrame = 0;
-                    audio->nCurrentSample = 0;
+                    audio->nSeekFrame = 0;
+
+                    PublishAudioTimeline(audio, 0, GetCurrentTime100ns());
                 }
             }
 
@@ -81,10 +258,15 @@ DWORD WINAPI AudioMain(LPVOID lpThreadParameter) {
         }
     }
 
+    if (scrubbing) {
+        timeEndPeriod(SCRUB_TIMER_RESOLUTION);
+    }
+
     audio->lpAudioClient->Stop();
 
     SAFERELEASE(audio->lpAudioClient);
     SAFERELEASE(audio->lpAudioRenderer);
+    SAFERELEASE(audio->lpAudioClock);
 
     CloseHandle(audio->hSignal);
 
@@ -116,7 +298,8 @@ AUDIOPTR InitializeAudio() {
     return audio;
 }
 
-BOOL PlayAudio(AUDIOPTR lpAudio, WAVEPTR lpWav) {
+// Metrics of the session are measured from the request, that is from when the user asked for the wave.
+BOOL PlayAudio(AUDIOPTR lpAudio, WAVEPTR lpWav, UINT64 nRequestTime) {
     if (lpAudio == NULL || lpWav == NULL) { return FALSE; }
 
     // Stop current playback, if any, and release audio resources,
@@ -128,6 +311,7 @@ BOOL PlayAudio(AUDIOPTR lpAudio, WAVEPTR lpWav) {
             lpAudio->lpAudioClient->Stop();
             lpAudio->lpAudioClient->Reset();
 
+            SAFERELEASE(lpAudio->lpAudioClock);
             SAFERELEASE(lpAudio->lpAudioRenderer);
             SAFERELEASE(lpAudio->lpAudioClient);
         }
@@ -138,6 +322,19 @@ BOOL PlayAudio(AUDIOPTR lpAudio, WAVEPTR lpWav) {
         }
     }
 
+    // Reduce the bit depth of the wave to that of the endpoint, if it is 16 bits at the same rate.
+    // The stream volume stays at unity, any other would requantize the samples as well.
+    lpAudio->wfxOutput = lpWav->wfxFormat;
+    lpAudio->bDithering = lpAudio->bDither && IsDitherSupported(&lpWav->wfxFormat)
+        && IsDitherEndpoint(lpAudio->lpDevice, lpWav->wfxFormat.nSamplesPerSec)
+        && InitializeDither(&lpAudio->dtDither, &lpWav->wfxFormat, lpAudio->dwDitherShape);
+
+    if (lpAudio->bDithering) {
+        lpAudio->wfxOutput.wBitsPerSample = DITHER_OUTPUT_BITS;
+        lpAudio->wfxOutput.nBlockAlign = lpAudio->wfxOutput.nChannels * (DITHER_OUTPUT_BITS >> 3);
+        lpAudio->wfxOutput.nAvgBytesPerSec = lpAudio->wfxOutput.nSamplesPerSec * lpAudio->wfxOutput.nBlockAlign;
+    }
+
     // Activate new audio client.
     if (FAILED(lpAudio->lpDevice->Activate(__uuidof(IAudioClient),
         CLSCTX_ALL, NULL, (LPVOID*)&lpAudio->lpAudioClient))) {
@@ -146,7 +343,7 @@ BOOL PlayAudio(AUDIOPTR lpAudio, WAVEPTR lpWav) {
 
     if (FAILED(lpAudio->lpAudioClient->Initialize(AUDCLNT_SHAREMODE_SHARED,
         AUDCLNT_STREAMFLAGS_RATEADJUST | AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM | AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY,
-        20000000, 0, &lpWav->wfxFormat, &GUID_NULL))) {
+        20000000, 0, &lpAudio->wfxOutput, &GUID_NULL))) {
         SAFERELEASE(lpAudio->lpAudioClient);
         return FALSE;
     }
@@ -156,37 +353,84 @@ BOOL PlayAudio(AUDIOPTR lpAudio, WAVEPTR lpWav) {
         return FALSE;
     }
 
+    if (FAILED(lpAudio->lpAudioClient->GetService(__uuidof(IAudioClock), (LPVOID*)&lpAudio->lpAudioClock))) {
+        SAFERELEASE(lpAudio->lpAudioRenderer);
+        SAFERELEASE(lpAudio->lpAudioClient);
+        return FALSE;
+    }
+
+    if (FAILED(lpAudio->lpAudioClock->GetFrequency(&lpAudio->nClockFrequency))
+        || lpAudio->nClockFrequency == 0) {
+        SAFERELEASE(lpAudio->lpAudioClock);
+        SAFERELEASE(lpAudio->lpAudioRenderer);
+        SAFERELEASE(lpAudio->lpAudioClient);
+        return FALSE;
+    }
+
     if (FAILED(lpAudio->lpAudioClient->GetBufferSize(&lpAudio->nBufferSize))) {
+        SAFERELEASE(lpAudio->lpAudioClock);
         SAFERELEASE(lpAudio->lpAudioRenderer);
         SAFERELEASE(lpAudio->lpAudioClient);
         return FALSE;
     }
 
     if (FAILED(lpAudio->lpAudioClient->Start())) {
+        SAFERELEASE(lpAudio->lpAudioClock);
         SAFERELEASE(lpAudio->lpAudioRenderer);
         SAFERELEASE(lpAudio->lpAudioClient);
         return FALSE;
     }
 
+    // Scrubbing keeps a device period and a hop ahead, formats it does not support seek instead.
+    REFERENCE_TIME period = 0;
+    if (FAILED(lpAudio->lpAudioClient->GetDevicePeriod(&period, NULL))) { period = 0; }
+
+    InitializeScrub(&lpAudio->scScrub, &lpWav->wfxFormat);
+
+    lpAudio->nScrubPadding = min((UINT32)(period * lpWav->wfxFormat.nSamplesPerSec / HUNDRED_NANOSECONDS_PER_SECOND)
+        + lpAudio->scScrub.nHopSize, lpAudio->nBufferSize);
+    lpAudio->bScrub = FALSE;
+    lpAudio->bScrubEnd = FALSE;
+
     lpAudio->hSignal = CreateEventA(NULL, TRUE, FALSE, NULL);
 
     if (lpAudio->hSignal == NULL) {
+        SAFERELEASE(lpAudio->lpAudioClock);
         SAFERELEASE(lpAudio->lpAudioRenderer);
         SAFERELEASE(lpAudio->lpAudioClient);
         return FALSE;
     }
 
+    // The new stream starts from its beginning, and so does the timeline.
+    lpAudio->nCurrentFrame = 0;
+    lpAudio->nSeekFrame = 0;
+    lpAudio->nSubmittedFrames = 0;
+    lpAudio->lpWave = lpWav;
+
+    PublishAudioTimeline(lpAudio, 0, GetCurrentTime100ns());
+
+    lpAudio->nRequestTime = nRequestTime;
+    ZeroMemory(&lpAudio->amMetrics, sizeof(AUDIOMETRICS));
+
     lpAudio->dwState = AUDIOSTATE_PLAY;
     lpAudio->hThread = CreateThread(NULL, 0, AudioMain, lpAudio, 0, NULL);
 
+    if (lpAudio->hThread != NULL && lpAudio->dwAffinity != 0) {
+        SetThreadAffinityMask(lpAudio->hThread, lpAudio->dwAffinity);
+    }
+
     if (lpAudio->hThread == NULL) {
+        lpAudio->dwState = AUDIOSTATE_IDLE;
+        lpAudio->lpWave = NULL;
+
         CloseHandle(lpAudio->hSignal);
+        SAFERELEASE(lpAudio->lpAudioClock);
         SAFERELEASE(lpAudio->lpAudioRenderer);
         SAFERELEASE(lpAudio->lpAudioClient);
         return FALSE;
     }
 
-    lpAudio->lpWave = lpWav;
+    lpAudio->amMetrics.dwBlockingTime = GetAudioElapsedTime(lpAudio);
 
     return TRUE;
 }
@@ -218,7 +462,9 @@ VOID StopAudio(AUDIOPTR lpAudio) {
     if (lpAudio->dwState != AUDIOSTATE_IDLE) {
         lpAudio->dwState = AUDIOSTATE_IDLE;
         lpAudio->nCurrentFrame = 0;
-        lpAudio->nCurrentSample = 0;
+        lpAudio->nSeekFrame = 0;
+
+        PublishAudioTimeline(lpAudio, 0, GetCurrentTime100ns());
     }
 }
 
@@ -243,12 +489,21 @@ VOID ReleaseAudio(AUDIOPTR lpAudio) {
     FreeMemory(lpAudio);
 }
 
+UINT64 GetAudioFramePosition(AUDIOPTR lpAudio) {
+    if (lpAudio == NULL) { return 0; }
+    if (!IsAudioPresent(lpAudio)) { return 0; }
+
+    CONST UINT64 frame = GetTimelineFrame(&lpAudio->tlTimeline, GetCurrentTime100ns(),
+        lpAudio->lpWave->wfxFormat.nSamplesPerSec, lpAudio->dwState == AUDIOSTATE_PLAY);
+
+    return min(frame, (UINT64)lpAudio->lpWave->dwNumFrames);
+}
+
 DWORD GetAudioPosition(AUDIOPTR lpAudio) {
     if (lpAudio == NULL) { return 0; }
     if (!IsAudioPresent(lpAudio)) { return 0; }
 
-    return lpAudio->nCurrentSample
-        / (lpAudio->lpWave->wfxFormat.nChannels * lpAudio->lpWave->wfxFormat.nSamplesPerSec);
+    return (DWORD)(GetAudioFramePosition(lpAudio) / lpAudio->lpWave->wfxFormat.nSamplesPerSec);
 }
 
 DWORD GetAudioLength(AUDIOPTR lpAudio) {
@@ -269,19 +524,54 @@ VOID SetAudioPosition(AUDIOPTR lpAudio, DWORD dwSeconds) {
         // Pause playback to avoid audio artifacts.
         if (play) { PauseAudio(lpAudio); }
 
-        // Calculate new frame and sample values for playback.
-        CONST UINT32 sample =
-            dwSeconds * lpAudio->lpWave->wfxFormat.nChannels * lpAudio->lpWave->wfxFormat.nSamplesPerSec;
-        CONST UINT32 frame = sample / lpAudio->lpWave->wfxFormat.nChannels;
+        // Calculate new frame value for playback.
+        CONST UINT64 frame = (UINT64)dwSeconds * lpAudio->lpWave->wfxFormat.nSamplesPerSec;
 
-        lpAudio->nCurrentSample = sample;
         lpAudio->nCurrentFrame = frame;
+        lpAudio->nSeekFrame = frame;
+
+        PublishAudioTimeline(lpAudio, frame, GetCurrentTime100ns());
 
         // Resume playback if it was paused.
         if (play) { ResumeAudio(lpAudio); }
     }
 }
 
+// Moves the read head of the scrubbing towards the frame, starting the scrubbing if needed.
+// Returns FALSE if the format of the audio can not be scrubbed.
+BOOL ScrubAudio(AUDIOPTR lpAudio, UINT64 nFrame) {
+    if (lpAudio == NULL) { return FALSE; }
+    if (!IsAudioPresent(lpAudio)) { return FALSE; }
+    if (lpAudio->scScrub.nGrainSize == 0) { return FALSE; }
+
+    nFrame = min(nFrame, (UINT64)lpAudio->lpWave->dwNumFrames);
+
+    InterlockedExchange(&lpAudio->nScrubFrame, (LONG)(DWORD)nFrame);
+    InterlockedExchange(&lpAudio->bScrubEnd, FALSE);
+
+    // Only the first request wakes the audio thread, the rest just move the target.
+    if (InterlockedExchange(&lpAudio->bScrub, TRUE) == FALSE) {
+        SetEvent(lpAudio->hSignal);
+    }
+
+    return TRUE;
+}
+
+// Scrubbing ends on the audio thread, so that a quick drag it has not seen yet still seeks.
+VOID EndAudioScrub(AUDIOPTR lpAudio) {
+    if (lpAudio == NULL) { return; }
+    if (!lpAudio->bScrub) { return; }
+
+    InterlockedExchange(&lpAudio->bScrubEnd, TRUE);
+    SetEvent(lpAudio->hSignal);
+}
+
+BOOL IsAudioScrubbing(AUDIOPTR lpAudio) {
+    if (lpAudio == NULL) { return FALSE; }
+
+    return IsAudioPresent(lpAudio) && lpAudio->bScrub;
+}
+
 BOOL IsAudioIdle(AUDIOPTR lpAudio) {
     if (lpAudio == NULL) { return FALSE; }
 
@@ -305,4 +595,14 @@ BOOL IsAudioPresent(AUDIOPTR lpAudio) {
     if (lpAudio->dwState == AUDIOSTATE_EXIT) { return FALSE; }
 
     return lpAudio->lpWave != NULL;
+}
+
+VOID GetAudioMetrics(AUDIOPTR lpAudio, AUDIOMETRICSPTR lpMetrics) {
+    if (lpMetrics == NULL) { return; }
+
+    ZeroMemory(lpMetrics, sizeof(AUDIOMETRICS));
+
+    if (lpAudio == NULL) { return; }
+
+    CopyMemory(lpMetrics, &lpAudio->amMetrics, sizeof(AUDIOMETRICS));
 }
\ No newline at end of file
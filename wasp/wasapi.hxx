@@ -22,6 +22,9 @@ SOFTWARE.
 
 #pragma once
 
+#include "dither.hxx"
+#include "scrub.hxx"
+#include "timeline.hxx"
 #include "wave.hxx"
 
 #include <mmdeviceapi.h>
@@ -34,9 +37,15 @@ typedef enum AudioState {
     AUDIOSTATE_FORCE_DWORD  = 0x7FFFFFFF
 } AUDIOSTATE, * AUDIOSTATEPTR;
 
+typedef struct AudioMetrics {
+    DWORD                   dwBlockingTime;     // In Microseconds, from the request until PlayAudio returned.
+    DWORD                   dwFirstAudioTime;   // In Microseconds, from the request until the first frame was submitted.
+} AUDIOMETRICS, * AUDIOMETRICSPTR;
+
 typedef struct Audio {
     HANDLE                  hThread;
     HANDLE                  hSignal;
+    DWORD_PTR               dwAffinity;         // Cores the audio thread runs on, 0 for any.
 
     WAVEPTR                 lpWave;
     AUDIOSTATE              dwState;
@@ -44,26 +53,59 @@ typedef struct Audio {
     IMMDevice*              lpDevice;
     IAudioClient*           lpAudioClient;
     IAudioRenderClient*     lpAudioRenderer;
+    IAudioClock*            lpAudioClock;
     UINT32                  nBufferSize;        // In Frames
-
-    UINT32                  nCurrentFrame;
-    UINT32                  nCurrentSample;
+    UINT64                  nClockFrequency;    // In Device Position Units per Second
+
+    UINT64                  nCurrentFrame;      // Next frame to be written.
+    UINT64                  nSeekFrame;         // Frame playback was last started or seeked from.
+    UINT64                  nSubmittedFrames;   // Frames written to the device since the stream started.
+
+    // Metrics of the current session, that is of the last PlayAudio.
+    UINT64                  nRequestTime;       // In 100ns Units of the Performance Counter
+    AUDIOMETRICS            amMetrics;
+
+    TIMELINE                tlTimeline;         // Frame being heard, published along with the next frame to be written.
+
+    // Scrubbing requests of the UI thread. They coalesce, as the audio thread
+    // only ever renders towards the latest target.
+    volatile LONG           bScrub;
+    volatile LONG           bScrubEnd;          // Thumb was released, the audio thread ends the scrubbing.
+    volatile LONG           nScrubFrame;        // Frame under the thumb of the seek bar.
+    UINT32                  nScrubPadding;      // In Frames, queued ahead of the device while scrubbing.
+    SCRUB                   scScrub;
+
+    // Sources with more bits than a 16-bit endpoint are dithered here,
+    // instead of being truncated by the audio engine.
+    BOOL                    bDither;            // Allow the bit depth reduction on output.
+    DITHERSHAPE             dwDitherShape;
+    BOOL                    bDithering;         // Stream runs at 16 bits, below the wave.
+    WAVEFORMATEX            wfxOutput;          // Format of the stream.
+    DITHER                  dtDither;
+    BYTE                    aStaging[MAX_SCRUB_GRAIN_SIZE / 2 * MAX_DITHER_CHANNELS * sizeof(INT)];    // Frames before the reduction.
 } AUDIO, * AUDIOPTR;
 
 AUDIOPTR InitializeAudio();
 
-BOOL PlayAudio(AUDIOPTR lpAudio, WAVEPTR lpWav);
+BOOL PlayAudio(AUDIOPTR lpAudio, WAVEPTR lpWav, UINT64 nRequestTime);
 VOID ResumeAudio(AUDIOPTR lpAudio);
 VOID PauseAudio(AUDIOPTR lpAudio);
 VOID StopAudio(AUDIOPTR lpAudio);
 VOID ReleaseAudio(AUDIOPTR lpAudio);
 
+UINT64 GetAudioFramePosition(AUDIOPTR lpAudio);
 DWORD GetAudioPosition(AUDIOPTR lpAudio);
 DWORD GetAudioLength(AUDIOPTR lpAudio);
 VOID SetAudioPosition(AUDIOPTR lpAudio, DWORD dwSeconds);
 
+BOOL ScrubAudio(AUDIOPTR lpAudio, UINT64 nFrame);
+VOID EndAudioScrub(AUDIOPTR lpAudio);
+BOOL IsAudioScrubbing(AUDIOPTR lpAudio);
+
 BOOL IsAudioIdle(AUDIOPTR lpAudio);
 BOOL IsAudioPlaying(AUDIOPTR lpAudio);
 BOOL IsAudioPaused(AUDIOPTR lpAudio);
 
-BOOL IsAudioPresent(AUDIOPTR lpAudio);
\ No newline at end of file
+BOOL IsAudioPresent(AUDIOPTR lpAudio);
+
+VOID GetAudioMetrics(AUDIOPTR lpAudio, AUDIOMETRICSPTR lpMetrics);
\ No newline at end of file
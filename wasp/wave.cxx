@@ -27,17 +27,273 @@ SOFTWARE.
 
 #define MIN_WAVE_FILE_SIZE  38
 
+// Large enough for any supported format, including MS ADPCM coefficients.
+#define MAX_WAVE_FORMAT_SIZE    256
+
+// Amount of audio loaded synchronously before OpenWave returns,
+// so that playback can start while the rest of the file is being loaded.
+#define WAVE_PRELOAD_IN_SECONDS     (1.0f / 4.0f)
+
+// Size of a single read performed by the background loader.
+#define WAVE_LOAD_SLICE_SIZE        (1024 * 1024)
+
+// Loader threads that are running, waves get those when there are no job workers.
+static volatile LONG LoaderThreads;
+
 BOOL IsWaveFile(RIFFLIST* lpHeader) {
     return lpHeader->fcc == FCC('RIFF') && lpHeader->fccListType == FCC('WAVE');
 }
 
-WAVEPTR OpenWave(LPCSTR lpszPath) {
+// Saturates at MAXDWORD, a little over 71 minutes.
+DWORD GetElapsedTime(LARGE_INTEGER liSince) {
+    LARGE_INTEGER now, frequency;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+
+    CONST UINT64 ticks = (UINT64)(now.QuadPart - liSince.QuadPart);
+    CONST UINT64 elapsed = ticks / frequency.QuadPart * 1000000
+        + ticks % frequency.QuadPart * 1000000 / frequency.QuadPart;
+
+    return (DWORD)min(elapsed, MAXDWORD);
+}
+
+BOOL ReadWaveSlice(WAVEPTR lpWav, DWORD dwBytes) {
+    CONST DWORD loaded = lpWav->dwLoadedBytes;
+    CONST DWORD bytes = min(dwBytes, lpWav->dwDataSize - loaded);
+
+    DWORD read = 0;
+    if (!ReadFile(lpWav->hFile,
+        (LPVOID)((size_t)lpWav->lpSamples + loaded), bytes, &read, NULL) || read != bytes) {
+        return FALSE;
+    }
+
+    // Publish the new frontier only after the data is in place.
+    InterlockedExchange((volatile LONG*)&lpWav->dwLoadedBytes, (LONG)(loaded + read));
+
+    return TRUE;
+}
+
+BOOL CompressWaveSlice(WAVEPTR lpWav, DWORD dwBytes) {
+    SAMPLESTOREPTR store = &lpWav->ssStore;
+    CONST DWORD size = store->nFramesPerBlock * store->nBlockAlign;
+
+    // Read and compress whole blocks, one at a time, through the staging buffer.
+    DWORD bytes = 0;
+    do {
+        CONST DWORD loaded = lpWav->dwLoadedBytes;
+        CONST DWORD block = loaded / size;
+        CONST DWORD length = min(size, lpWav->dwDataSize - loaded);
+
+        DWORD read = 0;
+        if (!ReadFile(lpWav->hFile, lpWav->lpSamples, length, &read, NULL) || read != length) {
+            return FALSE;
+        }
+
+        // Data past the last frame of the store is read, but not kept.
+        CONST DWORD first = block * store->nFramesPerBlock;
+        CONST DWORD frames = first < store->nNumFrames
+            ? min(length / store->nBlockAlign, store->nNumFrames - first) : 0;
+
+        if (frames != 0 && !CompressSampleBlock(store, block, lpWav->lpSamples, frames)) {
+            return FALSE;
+        }
+
+        InterlockedExchange((volatile LONG*)&lpWav->dwLoadedBytes, (LONG)(loaded + length));
+
+        bytes += length;
+    } while (bytes < dwBytes && lpWav->dwLoadedBytes < lpWav->dwDataSize);
+
+    return TRUE;
+}
+
+BOOL LoadWaveSlice(WAVEPTR lpWav, DWORD dwBytes) {
+    return IsWaveStored(lpWav)
+        ? CompressWaveSlice(lpWav, dwBytes) : ReadWaveSlice(lpWav, dwBytes);
+}
+
+VOID CompleteWaveLoad(WAVEPTR lpWav) {
+    CloseHandle(lpWav->hFile);
+    lpWav->hFile = NULL;
+
+    // Staging and encoder buffers are no longer needed once all the blocks are compressed.
+    if (IsWaveStored(lpWav)) {
+        FreeMemory(lpWav->lpSamples);
+        lpWav->lpSamples = NULL;
+
+        CompleteSampleStore(&lpWav->ssStore);
+    }
+
+    lpWav->wmMetrics.dwLoadTime = GetElapsedTime(lpWav->liOpenTime);
+
+    SetEvent(lpWav->hLoaded);
+}
+
+VOID FreeWave(WAVEPTR lpWav) {
+    if (lpWav->hFile != NULL) {
+        CloseHandle(lpWav->hFile);
+    }
+
+    if (lpWav->hLoaded != NULL) {
+        CloseHandle(lpWav->hLoaded);
+    }
+
+    if (lpWav->lpSamples != NULL) {
+        FreeMemory(lpWav->lpSamples);
+    }
+
+    ReleaseSampleStore(&lpWav->ssStore);
+    ReleaseWaveCodec(&lpWav->wcCodec);
+
+    FreeMemory(lpWav);
+}
+
+// Loads a single slice per run, so that more important jobs can go first in between.
+// Cancelled load leaves the file open, so that it can be resumed later.
+BOOL WaveLoadJob(LPVOID lpParameter, JOBPTR lpJob) {
+    WAVEPTR wav = (WAVEPTR)lpParameter;
+
+    // Loading was requested again, possibly after the job was cancelled, keep going.
+    if (InterlockedCompareExchange(&wav->nLoadState,
+        WAVE_LOAD_RUNNING, WAVE_LOAD_RESUMED) == WAVE_LOAD_RESUMED) {
+        RenewJob(lpJob);
+    }
+
+    if (!wav->bCancel && !IsJobCancelled(lpJob)) {
+        if (!LoadWaveSlice(wav, WAVE_LOAD_SLICE_SIZE)) {
+            // Truncate the track to what was loaded, so that playback
+            // ends at the frontier instead of waiting for it forever.
+            CONST DWORD frames = GetWaveCodecFrames(&wav->wcCodec,
+                wav->dwLoadedBytes - wav->dwLoadedBytes % wav->wcCodec.wfxSource.nBlockAlign);
+
+            wav->dwNumSamples = frames * wav->wfxFormat.nChannels;
+            InterlockedExchange((volatile LONG*)&wav->dwNumFrames, (LONG)frames);
+
+            CompleteWaveLoad(wav);
+        }
+        else if (wav->dwDataSize <= wav->dwLoadedBytes) {
+            CompleteWaveLoad(wav);
+        }
+        else {
+            if (lpJob != NULL) { lpJob->dwPriority = wav->dwPriority; }
+
+            return TRUE;
+        }
+    }
+
+    // Cancelled job stops, unless loading was requested again since the check above.
+    if (!wav->bCancel && wav->hFile != NULL) {
+        if (InterlockedCompareExchange(&wav->nLoadState,
+            WAVE_LOAD_IDLE, WAVE_LOAD_RUNNING) == WAVE_LOAD_RUNNING) {
+            return FALSE;
+        }
+
+        if (lpJob != NULL) { lpJob->dwPriority = wav->dwPriority; }
+
+        return TRUE;
+    }
+
+    // Wave that was released while the job was running is left for the job to free.
+    if (InterlockedExchange(&wav->nLoadState, WAVE_LOAD_IDLE) == WAVE_LOAD_RELEASED) {
+        FreeWave(wav);
+    }
+
+    return FALSE;
+}
+
+// Loads the wave when there are no job workers to do that.
+DWORD WINAPI WaveLoaderMain(LPVOID lpThreadParameter) {
+    while (WaveLoadJob(lpThreadParameter, NULL)) {}
+
+    InterlockedDecrement(&LoaderThreads);
+
+    return EXIT_SUCCESS;
+}
+
+BOOL ReadWaveHeader(WAVEPTR lpWav, UINT64 nFileSize, LPDWORD lpFrames) {
+    BOOL found = FALSE;
+    UINT64 offset = sizeof(RIFFLIST);
+
+    while (offset + sizeof(RIFFCHUNK) <= nFileSize) {
+        RIFFCHUNK chunk;
+
+        DWORD read = 0;
+        if (!ReadFile(lpWav->hFile, &chunk, sizeof(RIFFCHUNK), &read, NULL)
+            || read != sizeof(RIFFCHUNK)) {
+            return FALSE;
+        }
+
+        offset += sizeof(RIFFCHUNK);
+
+        // Search for format chunk. It must be present in a valid WAV file.
+        if (chunk.fcc == FCC('fmt ')) {
+            BYTE fmt[MAX_WAVE_FORMAT_SIZE];
+            ZeroMemory(fmt, MAX_WAVE_FORMAT_SIZE);
+
+            CONST DWORD size = min(chunk.cb, MAX_WAVE_FORMAT_SIZE);
+            if (!ReadFile(lpWav->hFile, fmt, size, &read, NULL) || read != size) {
+                return FALSE;
+            }
+
+            // Compressed formats stay compressed in memory,
+            // the codec decodes them into PCM during playback.
+            ReleaseWaveCodec(&lpWav->wcCodec);
+
+            if (!InitializeWaveCodec(&lpWav->wcCodec, (LPWAVEFORMATEX)fmt, size, &lpWav->wfxFormat)) {
+                return FALSE;
+            }
+
+            found = TRUE;
+        }
+        // Compressed formats may specify exact number of frames in the fact chunk.
+        else if (chunk.fcc == FCC('fact') && chunk.cb >= sizeof(DWORD)) {
+            if (!ReadFile(lpWav->hFile, lpFrames, sizeof(DWORD), &read, NULL) || read != sizeof(DWORD)) {
+                return FALSE;
+            }
+        }
+        // Search for data chunk. It must be present in a valid WAV file.
+        else if (chunk.fcc == FCC('data')) {
+            // Ensure that the format chunk preceeded the data chunk in the file.
+            if (!found) { return FALSE; }
+
+            // Ensure that the file contains at least the same amount of data
+            // as specified in the data chunk size.
+            if (nFileSize - offset < chunk.cb) { return FALSE; }
+
+            // The file pointer is left at the start of the sample data.
+            lpWav->dwDataSize = chunk.cb;
+
+            return TRUE;
+        }
+
+        if (nFileSize - offset < RIFFROUND((UINT64)chunk.cb)) { return FALSE; }
+
+        offset += RIFFROUND((UINT64)chunk.cb);
+
+        LARGE_INTEGER position;
+        position.QuadPart = offset;
+        SetFilePointerEx(lpWav->hFile, position, NULL, FILE_BEGIN);
+    }
+
+    return FALSE;
+}
+
+WAVEPTR OpenWave(LPCSTR lpszPath, DWORD dwFlags) {
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+
     HANDLE file = CreateFileA(lpszPath, GENERIC_READ, FILE_SHARE_READ, NULL,
-        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
 
     if (file == INVALID_HANDLE_VALUE) { return NULL; }
 
-    DWORD size = GetFileSize(file, NULL);
+    // RIFF chunk can not exceed 4GB past its header, ignore anything past that.
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(file, &length)) {
+        CloseHandle(file);
+        return NULL;
+    }
+
+    CONST UINT64 size = min((UINT64)length.QuadPart, sizeof(RIFFCHUNK) + (UINT64)MAXDWORD);
 
     if (size < MIN_WAVE_FILE_SIZE) {
         CloseHandle(file);
@@ -45,9 +301,9 @@ WAVEPTR OpenWave(LPCSTR lpszPath) {
     }
 
     DWORD read = 0;
-    BYTE bytes[MIN_WAVE_FILE_SIZE];
-    if (!ReadFile(file, bytes, MIN_WAVE_FILE_SIZE, &read, NULL)
-        || read != MIN_WAVE_FILE_SIZE || !IsWaveFile((RIFFLIST*)bytes)) {
+    RIFFLIST header;
+    if (!ReadFile(file, &header, sizeof(RIFFLIST), &read, NULL)
+        || read != sizeof(RIFFLIST) || !IsWaveFile(&header)) {
         CloseHandle(file);
         return NULL;
     }
@@ -63,85 +319,208 @@ WAVEPTR OpenWave(LPCSTR lpszPath) {
 
     strcpy(wav->szPath, lpszPath);
 
-    LPVOID data = AllocateMemory(size);
+    wav->hFile = file;
+    wav->hLoaded = CreateEventA(NULL, TRUE, FALSE, NULL);
+    wav->liOpenTime = start;
+    wav->nRefCount = 1;
 
-    if (data == NULL) {
-        FreeMemory(wav);
-        CloseHandle(file);
+    if (wav->hLoaded == NULL) {
+        ReleaseWave(wav);
         return NULL;
     }
 
-    SetFilePointer(file, 0, NULL, FILE_BEGIN);
+    DWORD frames = MAXDWORD;
+    if (!ReadWaveHeader(wav, size, &frames) || wav->wfxFormat.nBlockAlign == 0) {
+        ReleaseWave(wav);
+        return NULL;
+    }
 
-    if (!ReadFile(file, data, size, &read, NULL) || read != size) {
-        FreeMemory(wav);
-        FreeMemory(data);
-        CloseHandle(file);
+    // Fact chunk is only meaningful for compressed formats, PCM has as many frames as its data.
+    if (wav->wcCodec.wfxSource.wFormatTag == WAVE_FORMAT_PCM) { frames = MAXDWORD; }
+
+    wav->dwNumFrames = min(frames, GetWaveCodecFrames(&wav->wcCodec, wav->dwDataSize));
+    wav->dwNumSamples = wav->dwNumFrames * wav->wfxFormat.nChannels;
+
+    // Compression is optional, fall back to plain PCM if the store can not be used.
+    if (dwFlags & WAVE_FLAG_COMPRESS) {
+        InitializeSampleStore(&wav->ssStore, &wav->wcCodec.wfxSource, wav->dwNumFrames);
+    }
+
+    if (IsWaveStored(wav)) {
+        wav->lpSamples = AllocateMemory(wav->ssStore.nFramesPerBlock * wav->ssStore.nBlockAlign);
+    }
+    else {
+        // Allocate buffer for the whole sample data up front,
+        // it is filled in progressively by the background loader.
+        wav->lpSamples = AllocateMemory(wav->dwDataSize);
+    }
+
+    if (wav->lpSamples == NULL) {
+        ReleaseWave(wav);
         return NULL;
     }
 
-    CloseHandle(file);
+    // Load the beginning of the track synchronously, so that the playback
+    // can start immediately, and leave the rest to the background loader.
+    CONST LPWAVEFORMATEX source = &wav->wcCodec.wfxSource;
+    CONST DWORD preload = (DWORD)(source->nAvgBytesPerSec * WAVE_PRELOAD_IN_SECONDS);
 
-    BOOL found = FALSE;
-    CONST LPVOID end = (LPVOID)((size_t)data + size);
+    if (!LoadWaveSlice(wav, preload - preload % source->nBlockAlign + source->nBlockAlign)) {
+        ReleaseWave(wav);
+        return NULL;
+    }
 
-    for (RIFFCHUNK* chunk = (RIFFCHUNK*)((size_t)data + sizeof(RIFFLIST));
-        chunk < end; chunk = RIFFNEXT(chunk)) {
+    // The rest is loaded by a background job, see LoadWaveAsync.
+    if (wav->dwDataSize <= wav->dwLoadedBytes) {
+        CompleteWaveLoad(wav);
+    }
 
-        // Search for format chunk. It must be present in a valid WAV file.
-        if (chunk->fcc == FCC('fmt ')) {
-            LPWAVEFORMATEX fmt = (LPWAVEFORMATEX)((size_t)chunk + sizeof(RIFFCHUNK));
+    return wav;
+}
 
-            if (fmt->wFormatTag != WAVE_FORMAT_PCM) { break; }
+WAVEPTR AcquireWave(WAVEPTR lpWav) {
+    if (lpWav != NULL) {
+        InterlockedIncrement(&lpWav->nRefCount);
+    }
 
-            wav->wfxFormat.wFormatTag = fmt->wFormatTag;
-            wav->wfxFormat.nChannels = fmt->nChannels;
-            wav->wfxFormat.nSamplesPerSec = fmt->nSamplesPerSec;
-            wav->wfxFormat.nAvgBytesPerSec = fmt->nAvgBytesPerSec;
-            wav->wfxFormat.nBlockAlign = fmt->nBlockAlign;
-            wav->wfxFormat.wBitsPerSample = fmt->wBitsPerSample;
+    return lpWav;
+}
 
-            found = TRUE;
+VOID ReleaseWave(WAVEPTR lpWav) {
+    if (lpWav != NULL) {
+        if (InterlockedDecrement(&lpWav->nRefCount) != 0) { return; }
+
+        // Background job, if any, stops with its next run and frees the wave itself,
+        // so that the caller does not wait for it, nor for the jobs queued ahead of it.
+        InterlockedExchange(&lpWav->bCancel, TRUE);
+
+        if (InterlockedExchange(&lpWav->nLoadState, WAVE_LOAD_RELEASED) == WAVE_LOAD_IDLE) {
+            FreeWave(lpWav);
         }
-        // Search for data chunk. It must be present in a valid WAV file.
-        else if (chunk->fcc == FCC('data')) {
-            // Ensure that the format chunk preceeded the data chunk in the file.
-            if (!found) { break; }
+    }
+}
 
-            // Ensure that the file contains at least the same amount of data
-            // as specified in the data chunk size.
-            if (((size_t)end - (size_t)chunk - sizeof(RIFFCHUNK)) < chunk->cb) { break; }
+DWORD GetWaveLoadedFrames(WAVEPTR lpWav) {
+    if (lpWav == NULL) { return 0; }
+
+    // Only whole blocks can be decoded while the wave is still loading.
+    CONST DWORD loaded = lpWav->dwLoadedBytes;
+    CONST DWORD bytes = loaded < lpWav->dwDataSize
+        ? loaded - loaded % lpWav->wcCodec.wfxSource.nBlockAlign : loaded;
+
+    return min(GetWaveCodecFrames(&lpWav->wcCodec, bytes), lpWav->dwNumFrames);
+}
 
-            wav->dwNumFrames = chunk->cb / wav->wfxFormat.nBlockAlign;
-            wav->dwNumSamples = chunk->cb / (wav->wfxFormat.wBitsPerSample >> 3);
+BOOL LoadWaveAsync(WAVEPTR lpWav, JOBPRIORITY dwPriority) {
+    if (lpWav == NULL) { return FALSE; }
 
-            // Allocate another buffer for audio sample data,
-            // so that only it is used going forward, and not the whole file content.
-            wav->lpSamples = AllocateMemory(chunk->cb);
+    // Pending job picks up the new priority with its next slice.
+    lpWav->dwPriority = dwPriority;
 
-            if (wav->lpSamples != NULL) {
-                CopyMemory(wav->lpSamples,
-                    (LPVOID)((size_t)chunk + sizeof(RIFFCHUNK)), chunk->cb);
+    if (lpWav->hFile == NULL) { return TRUE; }
 
-                FreeMemory(data);
+    // Running job, even a cancelled one, is told to keep going instead of starting another.
+    for (;;) {
+        CONST LONG state = lpWav->nLoadState;
 
-                return wav;
+        if (state == WAVE_LOAD_RESUMED) { return TRUE; }
+
+        if (state == WAVE_LOAD_RUNNING) {
+            if (InterlockedCompareExchange(&lpWav->nLoadState,
+                WAVE_LOAD_RESUMED, WAVE_LOAD_RUNNING) == WAVE_LOAD_RUNNING) {
+                return TRUE;
             }
+
+            continue;
         }
+
+        if (InterlockedCompareExchange(&lpWav->nLoadState,
+            WAVE_LOAD_RUNNING, WAVE_LOAD_IDLE) == WAVE_LOAD_IDLE) {
+            break;
+        }
+    }
+
+    // Loading may have completed right before the job was claimed.
+    if (lpWav->hFile == NULL) {
+        InterlockedExchange(&lpWav->nLoadState, WAVE_LOAD_IDLE);
+        return TRUE;
+    }
+
+    if (SubmitJob(WaveLoadJob, lpWav, dwPriority)) { return TRUE; }
+
+    // Without workers, the wave gets a loader thread of its own.
+    InterlockedIncrement(&LoaderThreads);
+
+    HANDLE thread = CreateThread(NULL, 0, WaveLoaderMain, lpWav, 0, NULL);
+
+    if (thread == NULL) {
+        InterlockedDecrement(&LoaderThreads);
+        InterlockedExchange(&lpWav->nLoadState, WAVE_LOAD_IDLE);
+        return FALSE;
     }
 
-    FreeMemory(wav);
-    FreeMemory(data);
+    SetThreadPriority(thread, THREAD_PRIORITY_BELOW_NORMAL);
+    CloseHandle(thread);
 
-    return NULL;
+    return TRUE;
 }
 
-VOID ReleaseWave(WAVEPTR lpWav) {
-    if (lpWav != NULL) {
-        if (lpWav->lpSamples != NULL) {
-            FreeMemory(lpWav->lpSamples);
-        }
+BOOL IsWaveLoaded(WAVEPTR lpWav) {
+    if (lpWav == NULL) { return FALSE; }
+
+    return lpWav->dwNumFrames <= GetWaveLoadedFrames(lpWav);
+}
 
-        FreeMemory(lpWav);
+BOOL WaitForWaveLoad(WAVEPTR lpWav, DWORD dwMilliseconds) {
+    if (lpWav == NULL) { return FALSE; }
+
+    return WaitForSingleObject(lpWav->hLoaded, dwMilliseconds) == WAIT_OBJECT_0;
+}
+
+// Waits for the loader threads to exit, so that the files they keep open are closed.
+BOOL WaitForWaveLoaders(DWORD dwMilliseconds) {
+    for (DWORD i = 0; LoaderThreads != 0; i++) {
+        if (dwMilliseconds != INFINITE && dwMilliseconds <= i) { return FALSE; }
+
+        Sleep(1);
+    }
+
+    return TRUE;
+}
+
+BOOL IsWaveStored(WAVEPTR lpWav) {
+    if (lpWav == NULL) { return FALSE; }
+
+    return lpWav->ssStore.lpBlocks != NULL;
+}
+
+size_t GetWaveMemorySize(WAVEPTR lpWav) {
+    if (lpWav == NULL) { return 0; }
+
+    // Compressed size is only known once all the blocks are compressed,
+    // until then account for the worst case.
+    if (IsWaveStored(lpWav) && IsWaveLoaded(lpWav)) {
+        return lpWav->ssStore.nCompressedSize;
     }
+
+    return lpWav->dwDataSize;
+}
+
+VOID GetWaveMetrics(WAVEPTR lpWav, WAVEMETRICSPTR lpMetrics) {
+    if (lpMetrics == NULL) { return; }
+
+    ZeroMemory(lpMetrics, sizeof(WAVEMETRICS));
+
+    if (lpWav == NULL) { return; }
+
+    CopyMemory(lpMetrics, &lpWav->wmMetrics, sizeof(WAVEMETRICS));
+}
+
+VOID ReadWaveFrames(WAVEPTR lpWav, DWORD dwFrame, DWORD dwFrames, LPVOID lpOutput) {
+    if (IsWaveStored(lpWav)) {
+        ReadSampleStore(&lpWav->ssStore, dwFrame, dwFrames, lpOutput);
+        return;
+    }
+
+    DecodeWaveFrames(&lpWav->wcCodec, lpWav->lpSamples, lpWav->dwDataSize, dwFrame, dwFrames, lpOutput);
 }
\ No newline at end of file
@@ -25,14 +25,58 @@ SOFTWARE.
 #include <windows.h>
 #include <audioclient.h>
 
+#include "codec.hxx"
+#include "jobs.hxx"
+#include "store.hxx"
+
+// Keep PCM sample data losslessly compressed in memory.
+#define WAVE_FLAG_COMPRESS  0x1
+
+#define WAVE_LOAD_IDLE          0       // No background job is loading the wave.
+#define WAVE_LOAD_RUNNING       1       // Background job is loading the wave.
+#define WAVE_LOAD_RESUMED       2       // Loading was requested again while the job was running.
+#define WAVE_LOAD_RELEASED      3       // Last reference was released while the job was running, the job frees the wave.
+
+typedef struct WaveMetrics
+{
+    DWORD           dwLoadTime;         // Microseconds from OpenWave until all sample data was loaded.
+} WAVEMETRICS, * WAVEMETRICSPTR;
+
 typedef struct Wave
 {
     CHAR            szPath[MAX_PATH];
-    WAVEFORMATEX    wfxFormat;
+    WAVEFORMATEX    wfxFormat;          // Format of the decoded sample data.
+    WAVECODEC       wcCodec;
     DWORD           dwNumFrames;        // Total number of frames
     DWORD           dwNumSamples;       // Total number of samples
-    LPVOID          lpSamples;
+    LPVOID          lpSamples;          // Staging buffer for a single block when the store is used.
+    SAMPLESTORE     ssStore;
+
+    HANDLE          hFile;
+    HANDLE          hLoaded;            // Signaled once all sample data is loaded.
+    volatile LONG   nLoadState;         // State of the background job loading the remaining sample data.
+    volatile JOBPRIORITY dwPriority;    // Priority of the background job for its next slice.
+    DWORD           dwDataSize;         // Size of sample data, in bytes.
+    volatile DWORD  dwLoadedBytes;      // Load frontier, in bytes of sample data.
+    volatile LONG   bCancel;
+
+    LARGE_INTEGER   liOpenTime;
+    WAVEMETRICS     wmMetrics;
+
+    volatile LONG   nRefCount;          // Wave is freed when the last reference is released.
 } WAVE, * WAVEPTR;
 
-WAVEPTR OpenWave(LPCSTR lpszPath);
-VOID ReleaseWave(WAVEPTR lpWav);
\ No newline at end of file
+WAVEPTR OpenWave(LPCSTR lpszPath, DWORD dwFlags);
+WAVEPTR AcquireWave(WAVEPTR lpWav);
+VOID ReleaseWave(WAVEPTR lpWav);
+
+DWORD GetWaveLoadedFrames(WAVEPTR lpWav);
+BOOL LoadWaveAsync(WAVEPTR lpWav, JOBPRIORITY dwPriority);
+BOOL IsWaveLoaded(WAVEPTR lpWav);
+BOOL WaitForWaveLoad(WAVEPTR lpWav, DWORD dwMilliseconds);
+BOOL WaitForWaveLoaders(DWORD dwMilliseconds);
+BOOL IsWaveStored(WAVEPTR lpWav);
+size_t GetWaveMemorySize(WAVEPTR lpWav);
+VOID GetWaveMetrics(WAVEPTR lpWav, WAVEMETRICSPTR lpMetrics);
+
+VOID ReadWaveFrames(WAVEPTR lpWav, DWORD dwFrame, DWORD dwFrames, LPVOID lpOutput);
\ No newline at end of file